@@ -6,6 +6,12 @@
 
 using namespace emscripten;
 
+// Node counts are 64 bit, JS numbers hold them exactly up to 2^53 without needing BigInt
+static double getLimitNodes(const SearchLimits &limits) { return (double)limits.nodes; }
+static void setLimitNodes(SearchLimits &limits, double nodes) { limits.nodes = nodes > 0 ? (uint64_t)nodes : 0; }
+static double getSteps(const FinalEvaluation &evaluation) { return (double)evaluation.steps; }
+static void setSteps(FinalEvaluation &evaluation, double steps) { evaluation.steps = steps > 0 ? (uint64_t)steps : 0; }
+
 EMSCRIPTEN_BINDINGS(piece_enum) {
     function("pieceToString", &pieceToString);
     function("squareToString", &squareToString);
@@ -133,17 +139,29 @@ EMSCRIPTEN_BINDINGS(chess_engine_module) {
         .constructor<>()
         .function("makeMove", &Chess::makeMove)
         .function("getFen", &Chess::getFen)
+        .function("loadFen", &Chess::loadFen)
         .function("getPieceAt", &Chess::getPieceAt)
         .function("getLegalMovesAsJsArray", &Chess::getLegalMovesAsJsArray);
 
     class_<Minimax>("Minimax")
         .constructor<>()
-        .function("searchABPruning", &Minimax::searchABPruning);
+        .function("searchABPruning", &Minimax::searchABPruning)
+        .function("search", &Minimax::search);
+
+    value_object<SearchLimits>("SearchLimits")
+        .field("depth", &SearchLimits::depth)
+        .field("moveTime", &SearchLimits::moveTime)
+        .field("timeLeft", &SearchLimits::timeLeft)
+        .field("increment", &SearchLimits::increment)
+        .field("movesToGo", &SearchLimits::movesToGo)
+        .field("nodes", &getLimitNodes, &setLimitNodes)
+        .field("infinite", &SearchLimits::infinite);
     
     value_object<FinalEvaluation>("FinalEvaluation")
         .field("result", &FinalEvaluation::result)
         .field("move", &FinalEvaluation::move)
-        .field("steps", &FinalEvaluation::steps)
+        .field("steps", &getSteps, &setSteps)
+        .field("depth", &FinalEvaluation::depth)
         .field("heuristicTime", &FinalEvaluation::heuristicTime)
         .field("moveGenTime", &FinalEvaluation::moveGenTime);
 }
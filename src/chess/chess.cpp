@@ -1,7 +1,30 @@
 #include "chess.h"
+#include <algorithm>
+#include <sstream>
+
+// Bitboards of the initial position
+const uint64_t START_BOARD[14] = {
+    65535,                  // White pieces
+    18446462598732840960U,   // Black pieces
+    65280,                  // White pawns
+    71776119061217280U,      // Black pawns
+    66,                     // White knights
+    4755801206503243776U,    // Black knights
+    36,                     // White bishops
+    2594073385365405696U,    // Black bishops
+    129,                    // White rooks
+    9295429630892703744U,    // Black rooks
+    8,                      // White queens
+    576460752303423488U,     // Black queens
+    16,                     // White king
+    1152921504606846976U     // Black king
+};
 
 Chess::Chess(){
+    std::copy(std::begin(START_BOARD), std::end(START_BOARD), std::begin(currentBoard));
+    occupiedBoard = currentBoard[WHITE] | currentBoard[BLACK];
     gameState = CASTLE_A1 | CASTLE_H1 | CASTLE_A8 | CASTLE_H8;
+    enpassantSquare = A1;
     halfMoves = 0;
     totalMoves = 0;
     colorTurn = WHITE;
@@ -22,225 +45,19 @@ Chess::Chess(){
             pieceAt[sq] = static_cast<Piece>(p);
         }
     }
-}
-
-// Returns the origin of the attackers to a square.
-uint64_t Chess::attacksToSquare(Square sq, Piece color){
-    Piece attColor = (color == WHITE) ? BLACK : WHITE;
-
-    uint64_t bishopBlockers = generator.bishopMoves[sq] & occupiedBoard;
-    uint64_t rookBlockers = generator.rookMoves[sq] & occupiedBoard;
-    uint64_t diagonals = currentBoard[attColor + W_BISHOP] | currentBoard[attColor + W_QUEEN];
-    uint64_t lines = currentBoard[attColor + W_ROOK] | currentBoard[attColor + W_QUEEN];
-
-    uint64_t pawnAttack = generator.pawnAttacks[color][sq] & currentBoard[attColor + W_PAWN];
-    uint64_t kightAttack = generator.knightMoves[sq] & currentBoard[attColor + W_KNIGHT];
-    uint64_t bishopAttack = generator.bishopMoveboard[sq][bishopBlockers] & diagonals;
-    uint64_t rookAttack = generator.rookMoveboard[sq][rookBlockers] & lines;
-    uint64_t kingAttack = generator.kingMoves[sq] & currentBoard[attColor + W_KING];
-
-    uint64_t attacks = pawnAttack | kightAttack | bishopAttack | rookAttack | kingAttack;
 
-    return attacks;
+    key = computeKey();
+    pawnKey = computePawnKey();
+    computeScores();
 }
 
-void Chess::makeMove(Move pieceMove){
-    uint64_t i = 1;
-
-    uint8_t from = pieceMove.getFrom();
-    uint8_t to = pieceMove.getTo();
-    uint8_t flags = pieceMove.getFlags();
-    Piece pieceType = pieceAt[from];
-    captureHistory[totalMoves] = pieceAt[to];
-
-    // Update piece and color bitboards
-    uint64_t fromBB = (i << from);
-    uint64_t toBB = (i << to);
-    uint64_t fromToBB =  fromBB ^ toBB;
-    currentBoard[colorTurn] ^= fromToBB;
-    currentBoard[pieceType] ^= fromToBB;
-    pieceAt[from] = UNKNOWN;
-    pieceAt[to] = pieceType;
-
-    // Check if a rook move to disable castling
-    if(pieceType == (colorTurn + W_ROOK)){
-        switch(from){
-            case A1:
-                stateHistory[totalMoves] = gameState & CASTLE_A1;
-                gameState &= ~CASTLE_A1;
-                break;
-            case H1:
-                stateHistory[totalMoves] = gameState & CASTLE_H1;
-                gameState &= ~CASTLE_H1;
-                break;
-            case A8:
-                stateHistory[totalMoves] = gameState & CASTLE_A8;
-                gameState &= ~CASTLE_A8;
-                break;
-            case H8:
-                stateHistory[totalMoves] = gameState & CASTLE_H8;
-                gameState &= ~CASTLE_H8;
-                break;
-            default: break;
-        }
-    }
-    else if(pieceType == (colorTurn + W_KING)){
-        uint8_t newState = colorTurn == WHITE ? (CASTLE_A1 | CASTLE_H1) : (CASTLE_A8 | CASTLE_H8);
-        stateHistory[totalMoves] = gameState & newState;
-        gameState &= ~newState;
-    }
-
-    switch(flags) {
-        case KING_CASTLE: {
-            Square rookFrom = A1;
-            Square rookTo = A1;
-
-            if(colorTurn == WHITE) {
-                rookFrom = H1;
-                rookTo = F1;
-            }
-            else {
-                rookFrom = H8;
-                rookTo = F8;
-            }
-
-            fromBB = (i << rookFrom);
-            toBB = (i << rookTo);
-            fromToBB = fromBB ^ toBB;
-            currentBoard[colorTurn] ^= fromToBB;
-            currentBoard[colorTurn + W_ROOK] ^= fromToBB;
-            pieceAt[rookFrom] = UNKNOWN;
-            pieceAt[rookTo] = (Piece)(colorTurn + W_ROOK);
-            break;
-        }
-        case QUEEN_CASTLE: {
-            Square rookFrom = A1;
-            Square rookTo = A1;
-
-            if(colorTurn == WHITE) {
-                rookFrom = A1;
-                rookTo = D1;
-            }
-            else {
-                rookFrom = A8;
-                rookTo = D8;
-            }
-
-            fromBB = (i << rookFrom);
-            toBB = (i << rookTo);
-            fromToBB = fromBB ^ toBB;
-            currentBoard[colorTurn] ^= fromToBB;
-            currentBoard[colorTurn + W_ROOK] ^= fromToBB;
-            pieceAt[rookFrom] = UNKNOWN;
-            pieceAt[rookTo] = (Piece)(colorTurn + W_ROOK);
-            break;
-        }
-        case CAPTURE_MOVE: {
-            currentBoard[oppColor] ^= toBB;
-            currentBoard[captureHistory[totalMoves]] ^= toBB;
-
-            if(captureHistory[totalMoves] == (oppColor + W_ROOK)) {
-                switch(to){
-                    case A1:
-                        stateHistory[totalMoves] = gameState & CASTLE_A1;
-                        gameState &= ~CASTLE_A1;
-                        break;
-                    case H1:
-                        stateHistory[totalMoves] = gameState & CASTLE_H1;
-                        gameState &= ~CASTLE_H1;
-                        break;
-                    case A8:
-                        stateHistory[totalMoves] = gameState & CASTLE_A8;
-                        gameState &= ~CASTLE_A8;
-                        break;
-                    case H8:
-                        stateHistory[totalMoves] = gameState & CASTLE_H8;
-                        gameState &= ~CASTLE_H8;
-                        break;
-                    default: break;
-                }
-            }
-            break;
-        }
-        case KNIGHT_PROMOTION: case BISHOP_PROMOTION: case ROOK_PROMOTION: case QUEEN_PROMOTION: {
-            Piece promotionPiece = (Piece)(colorTurn + flagToPiece[flags - FLAG_OFFSET]);
-            currentBoard[pieceType] ^= toBB; // Remove pawn
-            currentBoard[promotionPiece] ^= toBB; // Add piece promoted
-            pieceAt[to] = promotionPiece; // At piece type for faster lookup
-            break;
-        }
-        case KNIGHT_PROMOTION_C: case BISHOP_PROMOTION_C: case ROOK_PROMOTION_C: case QUEEN_PROMOTION_C: {
-            Piece promotionPiece = (Piece)(colorTurn + flagToPiece[flags - FLAG_OFFSET]);
-            currentBoard[pieceType] ^= toBB;
-            currentBoard[promotionPiece] ^= toBB;
-            pieceAt[to] = promotionPiece;
-            
-            currentBoard[oppColor] ^= toBB;
-            currentBoard[captureHistory[totalMoves]] ^= toBB;
-
-            // If we captured a rook we disable castling rights
-            if(captureHistory[totalMoves] == (oppColor + W_ROOK)) {
-                switch(to){
-                    case A1:
-                        stateHistory[totalMoves] = gameState & CASTLE_A1;
-                        gameState &= ~CASTLE_A1;
-                        break;
-                    case H1:
-                        stateHistory[totalMoves] = gameState & CASTLE_H1;
-                        gameState &= ~CASTLE_H1;
-                        break;
-                    case A8:
-                        stateHistory[totalMoves] = gameState & CASTLE_A8;
-                        gameState &= ~CASTLE_A8;
-                        break;
-                    case H8:
-                        stateHistory[totalMoves] = gameState & CASTLE_H8;
-                        gameState &= ~CASTLE_H8;
-                        break;
-                    default: break;
-                }
-            }
-            break;
-        }
-        case DOUBLE_PAWN: {
-            if(colorTurn == WHITE) {
-                enpassant[totalMoves] = (Square)(from + 8U);
-            }
-            else {
-                enpassant[totalMoves] = (Square)(from - 8U);
-            }
-            break;
-        }
-        case EP_CAPTURE: {
-            // Offset to get en passant captured pawn
-            if(colorTurn == WHITE) {
-                to = (Square)(to - 8U);
-            }
-            else {
-                to = (Square)(to + 8U);
-            }
-            toBB = (i << to);
-            captureHistory[totalMoves] = pieceAt[to];
-            currentBoard[oppColor] ^= toBB;
-            currentBoard[captureHistory[totalMoves]] ^= toBB;
-            break;
-        }
-        default: break;
-    }
-
-    moveHistory[totalMoves] = pieceMove;
-    totalMoves++;
-
-    Piece temp = colorTurn;
-    colorTurn = oppColor;
-    oppColor = temp;
-
-    occupiedBoard = currentBoard[WHITE] | currentBoard[BLACK];
-}
-
-// Reverse the last move made. Used to check if the king is capture after a move, to known that is illegal.
-void Chess::undoMove(){
-    uint64_t i = 1;
+// Reverse the last move made, Us is the side that made it.
+template<Piece Us>
+void Chess::undoMoveFor(){
+    constexpr Piece Them = Us == WHITE ? BLACK : WHITE;
+    constexpr int forward = Us == WHITE ? 8 : -8;
+    constexpr uint64_t kingRookMove = Us == WHITE ? (1ULL << H1) | (1ULL << F1) : (1ULL << H8) | (1ULL << F8);
+    constexpr uint64_t queenRookMove = Us == WHITE ? (1ULL << A1) | (1ULL << D1) : (1ULL << A8) | (1ULL << D8);
 
     Move pieceMove = moveHistory[totalMoves - 1];
 
@@ -249,60 +66,28 @@ void Chess::undoMove(){
     uint8_t flags = pieceMove.getFlags();
     Piece pieceType = pieceAt[to];
 
-    uint64_t fromBB = (i << from);
-    uint64_t toBB = (i << to);
+    uint64_t fromBB = (1ULL << from);
+    uint64_t toBB = (1ULL << to);
     uint64_t fromToBB = fromBB ^ toBB;
-    currentBoard[oppColor] ^= fromToBB;
+    currentBoard[Us] ^= fromToBB;
     pieceAt[from] = pieceType;
     pieceAt[to] = UNKNOWN;
 
     switch(flags) {
         case KING_CASTLE: {
             currentBoard[pieceType] ^= fromToBB;
-
-            Square rookFrom = A1;
-            Square rookTo = A1;
-
-            if(oppColor == WHITE) {
-                rookFrom = H1;
-                rookTo = F1;
-            }
-            else {
-                rookFrom = H8;
-                rookTo = F8;
-            }
-
-            fromBB = (i << rookFrom);
-            toBB = (i << rookTo);
-            fromToBB = fromBB ^ toBB;
-            currentBoard[oppColor] ^= fromToBB;
-            currentBoard[oppColor + W_ROOK] ^= fromToBB;
-            pieceAt[rookFrom] = (Piece)(oppColor + W_ROOK);
-            pieceAt[rookTo] = UNKNOWN;
+            currentBoard[Us] ^= kingRookMove;
+            currentBoard[Us + W_ROOK] ^= kingRookMove;
+            pieceAt[Us == WHITE ? H1 : H8] = (Piece)(Us + W_ROOK);
+            pieceAt[Us == WHITE ? F1 : F8] = UNKNOWN;
             break;
         }
         case QUEEN_CASTLE: {
             currentBoard[pieceType] ^= fromToBB;
-
-            Square rookFrom = A1;
-            Square rookTo = A1;
-
-            if(oppColor == WHITE) {
-                rookFrom = A1;
-                rookTo = D1;
-            }
-            else {
-                rookFrom = A8;
-                rookTo = D8;
-            }
-
-            fromBB = (i << rookFrom);
-            toBB = (i << rookTo);
-            fromToBB = fromBB ^ toBB;
-            currentBoard[oppColor] ^= fromToBB;
-            currentBoard[oppColor + W_ROOK] ^= fromToBB;
-            pieceAt[rookFrom] = (Piece)(oppColor + W_ROOK);
-            pieceAt[rookTo] = UNKNOWN;
+            currentBoard[Us] ^= queenRookMove;
+            currentBoard[Us + W_ROOK] ^= queenRookMove;
+            pieceAt[Us == WHITE ? A1 : A8] = (Piece)(Us + W_ROOK);
+            pieceAt[Us == WHITE ? D1 : D8] = UNKNOWN;
             break;
         }
         case QUIET_MOVE: {
@@ -311,28 +96,27 @@ void Chess::undoMove(){
         }
         case DOUBLE_PAWN: {
             currentBoard[pieceType] ^= fromToBB;
-            enpassant[totalMoves - 1] = A1;
             break;
         }
         case CAPTURE_MOVE: {
             currentBoard[pieceType] ^= fromToBB;
-            currentBoard[colorTurn] ^= toBB;
+            currentBoard[Them] ^= toBB;
             currentBoard[captureHistory[totalMoves - 1]] ^= toBB;
             pieceAt[to] = captureHistory[totalMoves - 1];
             break;
         }
         case KNIGHT_PROMOTION: case BISHOP_PROMOTION: case ROOK_PROMOTION: case QUEEN_PROMOTION: {
             currentBoard[pieceType] ^= toBB;
-            currentBoard[oppColor + W_PAWN] ^= fromBB;
-            pieceAt[from] = (Piece)(oppColor + W_PAWN);
+            currentBoard[Us + W_PAWN] ^= fromBB;
+            pieceAt[from] = (Piece)(Us + W_PAWN);
             break;
         }
         case KNIGHT_PROMOTION_C: case BISHOP_PROMOTION_C: case ROOK_PROMOTION_C: case QUEEN_PROMOTION_C: {
             currentBoard[pieceType] ^= toBB;
-            currentBoard[oppColor + W_PAWN] ^= fromBB;
-            pieceAt[from] = (Piece)(oppColor + W_PAWN);     
+            currentBoard[Us + W_PAWN] ^= fromBB;
+            pieceAt[from] = (Piece)(Us + W_PAWN);     
             
-            currentBoard[colorTurn] ^= toBB;
+            currentBoard[Them] ^= toBB;
             currentBoard[captureHistory[totalMoves - 1]] ^= toBB;
             pieceAt[to] = captureHistory[totalMoves - 1];
             break;
@@ -341,15 +125,9 @@ void Chess::undoMove(){
             currentBoard[pieceType] ^= fromToBB;
 
             // Offset to get en passant captured pawn
-            if(oppColor == WHITE) {
-                to = (Square)(to - 8U);
-            }
-            else {
-                to = (Square)(to + 8U);
-            }
-
-            toBB = (i << to);
-            currentBoard[colorTurn] ^= toBB;
+            to = (Square)(to - forward);
+            toBB = (1ULL << to);
+            currentBoard[Them] ^= toBB;
             currentBoard[captureHistory[totalMoves - 1]] ^= toBB;
             pieceAt[to] = captureHistory[totalMoves - 1];
             break;
@@ -358,283 +136,64 @@ void Chess::undoMove(){
     }
 
     // We recover the state
-    if(stateHistory[totalMoves - 1] > 0){
-        gameState |= stateHistory[totalMoves - 1];
-        gameState &= ~GAME_OVER;
-    }
+    gameState = stateHistory[totalMoves - 1] & ~GAME_OVER;
+    enpassantSquare = enpassantHistory[totalMoves - 1];
+    key = keyHistory[totalMoves - 1];
+    pawnKey = pawnKeyHistory[totalMoves - 1];
+    halfMoves = halfMoveHistory[totalMoves - 1];
+    material = materialHistory[totalMoves - 1];
+    pstScore = pstHistory[totalMoves - 1];
+    phase = phaseHistory[totalMoves - 1];
 
     totalMoves--;
 
-    Piece temp = colorTurn;
-    colorTurn = oppColor;
-    oppColor = temp;
+    colorTurn = Us;
+    oppColor = Them;
 
     occupiedBoard = currentBoard[WHITE] | currentBoard[BLACK];
 }
 
-// Generates a list of moves for a given piece moveboard.
-inline void Chess::getMovesFromBB(MoveList &moveList, uint64_t bitboard, Square squareFrom, uint8_t flag){
-    switch(flag) {
-        case KNIGHT_PROMOTION: {
-            while(bitboard > 0){
-                Square squareTo = (Square)__builtin_ctzll(bitboard);
-                bitboard &= bitboard - 1;
-    
-                Move knightPromotion(squareFrom, squareTo, KNIGHT_PROMOTION);
-                Move bishopPromotion(squareFrom, squareTo, BISHOP_PROMOTION);
-                Move rookPromotion(squareFrom, squareTo, ROOK_PROMOTION);
-                Move queenPromotion(squareFrom, squareTo, QUEEN_PROMOTION);
-                moveList.add(knightPromotion);
-                moveList.add(bishopPromotion);
-                moveList.add(rookPromotion);
-                moveList.add(queenPromotion);
-            }
-            break;
-        }
-        case KNIGHT_PROMOTION_C: {
-            while(bitboard > 0){
-                Square squareTo = (Square)__builtin_ctzll(bitboard);
-                bitboard &= bitboard - 1;
-    
-                Move knightPromotion(squareFrom, squareTo, KNIGHT_PROMOTION_C);
-                Move bishopPromotion(squareFrom, squareTo, BISHOP_PROMOTION_C);
-                Move rookPromotion(squareFrom, squareTo, ROOK_PROMOTION_C);
-                Move queenPromotion(squareFrom, squareTo, QUEEN_PROMOTION_C);
-                moveList.add(knightPromotion);
-                moveList.add(bishopPromotion);
-                moveList.add(rookPromotion);
-                moveList.add(queenPromotion);
-            }
-            break;
-        }
-        case QUIET_MOVE: case CAPTURE_MOVE: case DOUBLE_PAWN: {
-            while(bitboard > 0){
-                Square squareTo = (Square)__builtin_ctzll(bitboard);
-                bitboard &= bitboard - 1;
-    
-                Move newMove(squareFrom, squareTo, flag);
-                moveList.add(newMove);
-            }
-            break;
-        }
-        default: break;
-    }
-}
-
-// Generates all the moves without checking if the king can be capture.
-MoveList Chess::getPseudoLegalMoves(){
-    uint64_t playerBoard = currentBoard[colorTurn];
-    MoveList moveList;
-
-    uint64_t promotionRow = colorTurn == WHITE ? LAST_ROW : FIRST_ROW;
-    Square doublePawnMin = colorTurn == WHITE ? A2 : A7;
-    Square doublePawnMax = colorTurn == WHITE ? H2 : H7;
-
-    uint64_t enpassantBB = 0;
-    if(enpassant[totalMoves - 1] > 0) {
-        enpassantBB = 1ULL << enpassant[totalMoves - 1];
-    }
-
-    int sq;
-    while(playerBoard){
-        sq = __builtin_ctzll(playerBoard);
-        playerBoard &= playerBoard - 1;
-
-        uint64_t moves = 0;
-        uint64_t captures = 0;
-        uint64_t promotions = 0;
-        uint64_t capturePromotions = 0;
-        Square doublePawn = A1;
-        Piece pieceType = pieceAt[sq];
-
-        switch(pieceType) {
-            case W_PAWN: case B_PAWN: {
-                moves = generator.pawnMoves[colorTurn][sq];
-                captures = generator.pawnAttacks[colorTurn][sq];
-
-                if(sq >= doublePawnMin && sq <= doublePawnMax) {
-                    uint64_t blockers = generator.doublePawns[colorTurn][sq] & occupiedBoard;
-                    doublePawn = (Square)generator.doublePawnMoveboard[sq][blockers];
-
-                    if(doublePawn != 0U) {
-                        Move doublePawnMove((Square)sq, doublePawn, DOUBLE_PAWN);
-                        moveList.add(doublePawnMove);
-                    }
-                }
-
-                if(enpassantBB && (enpassantBB & captures)) {
-                    Move enpassantMove((Square)sq, enpassant[totalMoves - 1], EP_CAPTURE);
-                    moveList.add(enpassantMove);
-                }
-                break;
-            }
-            case W_KNIGHT: case B_KNIGHT: {
-                moves = generator.knightMoves[sq];
-                captures = moves;
-                break;
-            }
-            case W_BISHOP: case B_BISHOP: {
-                uint64_t blockers = generator.bishopMoves[sq] & occupiedBoard;
-                moves = generator.bishopMoveboard[sq][blockers];
-                captures = moves;
-                break;
-            }
-            case W_ROOK: case B_ROOK: {
-                uint64_t blockers = generator.rookMoves[sq] & occupiedBoard;
-                moves = generator.rookMoveboard[sq][blockers];
-                captures = moves;
-                break;
-            }
-            case W_QUEEN: case B_QUEEN: {
-                uint64_t bishopBlockers = generator.bishopMoves[sq] & occupiedBoard;
-                uint64_t rookBlockers = generator.rookMoves[sq] & occupiedBoard;
-                moves = generator.bishopMoveboard[sq][bishopBlockers];
-                moves |= generator.rookMoveboard[sq][rookBlockers];
-                captures = moves;
-                break;
-            }
-            case W_KING: case B_KING: {
-                moves = generator.kingMoves[sq];
-                captures = moves;
-                break;
-            }
-            default: break;
-        }
-
-        moves &= ~occupiedBoard;
-        captures &= currentBoard[oppColor];
-
-        if(pieceType == W_PAWN || pieceType == B_PAWN) {
-            promotions = promotionRow & moves;
-            capturePromotions = promotionRow & captures;
-            moves &= ~promotionRow;
-            captures &= ~promotionRow;
-        }
-
-        if (moves > 0) {
-            getMovesFromBB(moveList, moves, (Square)sq, QUIET_MOVE);
-        }
-
-        if (captures > 0) {
-            getMovesFromBB(moveList, captures, (Square)sq, CAPTURE_MOVE);
-        }
-
-        if (promotions > 0) {
-            getMovesFromBB(moveList, promotions, (Square)sq, KNIGHT_PROMOTION);
-        }
-
-        if (capturePromotions > 0) {
-            getMovesFromBB(moveList, capturePromotions, (Square)sq, KNIGHT_PROMOTION_C);
-        }
-    }
-
-    // Check for castling rights, only if the king is not in check.
-    if(colorTurn == WHITE) {
-        if(gameState & CASTLE_A1){
-            Move newMove(E1, C1, QUEEN_CASTLE);
-            moveList.add(newMove);
-        }
-        if(gameState & CASTLE_H1){
-            Move newMove(E1, G1, KING_CASTLE);
-            moveList.add(newMove);
-        }
-    }
-    else {
-        if(gameState & CASTLE_A8){
-            Move newMove(E8, C8, QUEEN_CASTLE);
-            moveList.add(newMove);
-        }
-        if(gameState & CASTLE_H8){
-            Move newMove(E8, G8, KING_CASTLE);
-            moveList.add(newMove);
-        }
-    }
-
-    return moveList;
-}
-
-bool Chess::isLegal(Move move, Square kingSquare) {
-    uint8_t flags = move.getFlags();
-    uint8_t from = move.getFrom();
-    uint8_t to = move.getTo();
-
-    if((flags == KING_CASTLE) || (flags == QUEEN_CASTLE)) {
-        if(attacksToSquare(kingSquare, colorTurn)) return false;
-        
-        bool pathClear = false;
-        switch(to){
-            case C1: {
-                bool path = (occupiedBoard & 14) == 0;
-                pathClear = path && (attacksToSquare(D1, colorTurn) == 0) && (attacksToSquare(C1, colorTurn) == 0);
-                break;
-            }
-            case G1: {
-                bool path = (occupiedBoard & 96) == 0;
-                pathClear = path && (attacksToSquare(F1, colorTurn) == 0) && (attacksToSquare(G1, colorTurn) == 0);
-                break;
-            }
-            case C8: {
-                bool path = (occupiedBoard & 1008806316530991104U) == 0;
-                pathClear = path && (attacksToSquare(D8, colorTurn) == 0) && (attacksToSquare(C8, colorTurn) == 0);
-                break;
-            }
-            case G8: {
-                bool path = (occupiedBoard & 6917529027641081856U) == 0;
-                pathClear = path && (attacksToSquare(F8, colorTurn) == 0) && (attacksToSquare(G8, colorTurn) == 0);
-                break;
-            }
-            default: break;
-        }
-
-        return pathClear;
-    }
-    else if(pieceAt[from] == (Piece)(colorTurn + W_KING)) {
-        makeMove(move);
-        bool kingSafe = attacksToSquare((Square)move.getTo(), oppColor) == 0;
-        undoMove();
+// Refused once the history arrays are full, the position is left as it was
+bool Chess::makeMove(Move pieceMove){
+    if(totalMoves >= MAX_HISTORY) return false;
 
-        return kingSafe;
-    }
-
-    makeMove(move);
-    // OppColor because after making the move colors switch
-    bool kingSafe = attacksToSquare(kingSquare, oppColor) == 0;
-    undoMove();
-
-    return kingSafe;
+    // The whole state is saved, so undoMove can restore the castling rights and en passant square
+    moveHistory[totalMoves] = pieceMove;
+    stateHistory[totalMoves] = gameState;
+    enpassantHistory[totalMoves] = enpassantSquare;
+    keyHistory[totalMoves] = key;
+    pawnKeyHistory[totalMoves] = pawnKey;
+    halfMoveHistory[totalMoves] = halfMoves;
+    materialHistory[totalMoves] = material;
+    pstHistory[totalMoves] = pstScore;
+    phaseHistory[totalMoves] = phase;
+    captureHistory[totalMoves] = applyMove(pieceMove);
+    totalMoves++;
+    return true;
 }
 
-MoveList Chess::getLegalMoves(){
-    // auto t1 = std::chrono::high_resolution_clock::now();
-    
-    MoveList pseudoList = getPseudoLegalMoves();
-    MoveList legalMoves;
-    
-    Square kingSquare = (Square)__builtin_ctzll(currentBoard[colorTurn + W_KING]);
-    // Makes the move and checks if the king is attack to get the legal moves.
-    for(Move m: pseudoList){
-        if(isLegal(m, kingSquare)) {
-            legalMoves.add(m);
-        }
-    }
-
-    if(legalMoves.count == 0){
-        gameState |= GAME_OVER;
-        stateHistory[totalMoves - 1] |= GAME_OVER;
-    }
-
-    // auto t2 = std::chrono::high_resolution_clock::now();
-    // auto ms_int = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1);
-    // moveGenTime += ms_int.count();
-
-    return legalMoves;
+void Chess::undoMove(){
+    if(oppColor == WHITE) undoMoveFor<WHITE>();
+    else undoMoveFor<BLACK>();
+    #ifdef ZOBRIST_DEBUG
+    verifyKey(moveHistory[totalMoves]);
+    #endif
 }
 
 PerftResults Chess::perft(int depth) {
     PerftResults results;
 
+    // No room left in the history for the whole tree. Only the last move is needed for the counts, so a copy starts
+    // its history again from it.
+    if(totalMoves > 0 && totalMoves + depth > MAX_HISTORY) {
+        Chess position = *this;
+        position.moveHistory[0] = moveHistory[totalMoves - 1];
+        position.totalMoves = 1;
+        return position.perft(depth);
+    }
+
     MoveList moves = getLegalMoves();
-    uint8_t flags = moveHistory[totalMoves - 1].getFlags();
+    uint8_t flags = totalMoves > 0 ? moveHistory[totalMoves - 1].getFlags() : (uint8_t)QUIET_MOVE;
 
     if(depth == 0) {
         if(flags == CAPTURE_MOVE || flags == KNIGHT_PROMOTION_C 
@@ -789,8 +348,8 @@ std::string Chess::getFen() {
 
     // En passant
     fen += ' ';
-    if(enpassant[totalMoves - 1] > 0) {
-        fen += squareToString(enpassant[totalMoves - 1]);
+    if(enpassantSquare > 0) {
+        fen += squareToString(enpassantSquare);
     }
     else {
         fen += '-';
@@ -800,11 +359,128 @@ std::string Chess::getFen() {
     fen += ' ' + std::to_string(halfMoves);
 
     // Total moves
-    fen += ' ' + std::to_string((totalMoves / 2) + 1);
+    fen += ' ' + std::to_string(((startPly + totalMoves) / 2) + 1);
 
     return fen;
 }
 
+// Sets the position from a fen string. The move counters are optional, like in EPD files. If the fen is not valid
+// false is returned and the position is not changed.
+bool Chess::loadFen(const std::string &fen) {
+    std::istringstream fenStream(fen);
+    std::string boardField, colorField, castleField, enpassantField;
+    int halfMovesField = 0;
+    int fullMovesField = 1;
+
+    if(!(fenStream >> boardField >> colorField >> castleField >> enpassantField)) {
+        return false;
+    }
+    if(!(fenStream >> halfMovesField >> fullMovesField)) {
+        halfMovesField = 0;
+        fullMovesField = 1;
+    }
+
+    Chess loaded;
+    std::fill(std::begin(loaded.currentBoard), std::end(loaded.currentBoard), 0);
+    std::fill(std::begin(loaded.pieceAt), std::end(loaded.pieceAt), UNKNOWN);
+
+    // Pieces are placed from the 8th row to the 1st, same as getFen writes them
+    const std::string pieceChars = "PpNnBbRrQqKk";
+    int row = 7;
+    int column = 0;
+    for(char c : boardField) {
+        if(c == '/') {
+            if(column != 8 || row == 0) return false;
+            row--;
+            column = 0;
+        }
+        else if(c >= '1' && c <= '8') {
+            column += c - '0';
+            if(column > 8) return false;
+        }
+        else {
+            size_t pieceIndex = pieceChars.find(c);
+            if(pieceIndex == std::string::npos || column > 7) return false;
+
+            Piece piece = (Piece)(W_PAWN + pieceIndex);
+            int sq = row * 8 + column;
+            loaded.currentBoard[piece] |= 1ULL << sq;
+            loaded.currentBoard[piece % 2] |= 1ULL << sq;
+            loaded.pieceAt[sq] = piece;
+            column++;
+        }
+    }
+    if(row != 0 || column != 8) return false;
+
+    // Move generation needs exactly one king for each side
+    if(generator.bitCountSet(loaded.currentBoard[W_KING]) != 1 || generator.bitCountSet(loaded.currentBoard[B_KING]) != 1) {
+        return false;
+    }
+
+    loaded.occupiedBoard = loaded.currentBoard[WHITE] | loaded.currentBoard[BLACK];
+
+    if(colorField == "w") {
+        loaded.colorTurn = WHITE;
+        loaded.oppColor = BLACK;
+    }
+    else if(colorField == "b") {
+        loaded.colorTurn = BLACK;
+        loaded.oppColor = WHITE;
+    }
+    else {
+        return false;
+    }
+
+    // Castling rights are only kept if the king and rook are still in place, move generation trusts them
+    loaded.gameState = 0;
+    for(char c : castleField) {
+        switch(c) {
+            case 'K': loaded.gameState |= CASTLE_H1; break;
+            case 'Q': loaded.gameState |= CASTLE_A1; break;
+            case 'k': loaded.gameState |= CASTLE_H8; break;
+            case 'q': loaded.gameState |= CASTLE_A8; break;
+            case '-': break;
+            default: return false;
+        }
+    }
+    if(loaded.pieceAt[E1] != W_KING) loaded.gameState &= ~(CASTLE_A1 | CASTLE_H1);
+    if(loaded.pieceAt[E8] != B_KING) loaded.gameState &= ~(CASTLE_A8 | CASTLE_H8);
+    if(loaded.pieceAt[A1] != W_ROOK) loaded.gameState &= ~CASTLE_A1;
+    if(loaded.pieceAt[H1] != W_ROOK) loaded.gameState &= ~CASTLE_H1;
+    if(loaded.pieceAt[A8] != B_ROOK) loaded.gameState &= ~CASTLE_A8;
+    if(loaded.pieceAt[H8] != B_ROOK) loaded.gameState &= ~CASTLE_H8;
+
+    loaded.totalMoves = 0;
+    loaded.enpassantSquare = A1;
+    if(enpassantField != "-") {
+        if(enpassantField.size() != 2 || enpassantField[0] < 'a' || enpassantField[0] > 'h') return false;
+
+        char rank = loaded.colorTurn == WHITE ? '6' : '3';
+        if(enpassantField[1] != rank) return false;
+
+        // Only kept if a pawn just moved two squares past it, otherwise the capture would find no pawn to take
+        int sq = (enpassantField[1] - '1') * 8 + (enpassantField[0] - 'a');
+        int forward = loaded.colorTurn == WHITE ? 8 : -8;
+        if(loaded.pieceAt[sq] == UNKNOWN && loaded.pieceAt[sq + forward] == UNKNOWN
+            && loaded.pieceAt[sq - forward] == (Piece)(loaded.oppColor + W_PAWN)) {
+            loaded.enpassantSquare = (Square)sq;
+        }
+    }
+
+    // The side that just moved cant be left in check, its king would be captured
+    Square oppKingSquare = (Square)__builtin_ctzll(loaded.currentBoard[loaded.oppColor + W_KING]);
+    if(loaded.attacksToSquare(oppKingSquare, loaded.oppColor)) return false;
+
+    loaded.halfMoves = std::max(0, halfMovesField);
+    loaded.key = loaded.computeKey();
+    loaded.pawnKey = loaded.computePawnKey();
+    loaded.computeScores();
+    loaded.startPly = std::max(0, 2 * (fullMovesField - 1) + (loaded.colorTurn == BLACK ? 1 : 0));
+
+    *this = loaded;
+    return true;
+}
+
 Piece Chess::getPieceAt(Square from) {
     return pieceAt[from];
 }
@@ -8,7 +8,7 @@
 #include <emscripten/bind.h>
 #endif
 
-#include "generator.h"
+#include "position.h"
 #include "move_structs.h"
 
 typedef struct PerftResults {
@@ -27,58 +27,40 @@ typedef struct PerftResults {
     }
 } PerftResults;
 
-class Chess{
-public:
-    Generator generator;
-    Move moveHistory[512] = {};
-    uint8_t stateHistory[512] = { 0 };
-    Piece captureHistory[512] = { UNKNOWN };
-    Square enpassant[512] = { A1 };
+// Longest game the history arrays can hold
+const int MAX_HISTORY = 512;
 
-    // Array representing the current state of the board
-    uint64_t currentBoard[14] = {
-        65535,                  // White pieces
-        18446462598732840960U,   // Black pieces
-        65280,                  // White pawns
-        71776119061217280U,      // Black pawns
-        66,                     // White knights
-        4755801206503243776U,    // Black knights
-        36,                     // White bishops
-        2594073385365405696U,    // Black bishops
-        129,                    // White rooks
-        9295429630892703744U,    // Black rooks
-        8,                      // White queens
-        576460752303423488U,     // Black queens
-        16,                     // White king
-        1152921504606846976U     // Black king
-    };
-    uint64_t occupiedBoard = 18446462598732906495U;
-    // For faster lookup while move generating
-    Piece pieceAt[64]; 
+// A position with the history needed to undo moves, used by the GUI, perft and the root of the search.
+class Chess : public Position {
+public:
+    // Saved before every move, the entry of a move is at the index totalMoves had before making it
+    Move moveHistory[MAX_HISTORY] = {};
+    uint8_t stateHistory[MAX_HISTORY] = { 0 };
+    Piece captureHistory[MAX_HISTORY] = { UNKNOWN };
+    Square enpassantHistory[MAX_HISTORY] = { A1 };
+    // Keys of the previous positions, used to find repetitions
+    uint64_t keyHistory[MAX_HISTORY] = { 0 };
+    uint64_t pawnKeyHistory[MAX_HISTORY] = { 0 };
+    int halfMoveHistory[MAX_HISTORY] = { 0 };
+    Score materialHistory[MAX_HISTORY] = { 0 };
+    Score pstHistory[MAX_HISTORY] = { 0 };
+    int phaseHistory[MAX_HISTORY] = { 0 };
 
-    // Tell us about castling rights and who is going to move next
-    uint8_t gameState;
-    // Moves since capture or pawn move
-    int halfMoves;
     int totalMoves;
-
-    Piece colorTurn;
-    Piece oppColor;
+    // Plies played before the start of the history, only used for the move counter of the fen
+    int startPly = 0;
 
     long long moveGenTime = 0;
 
     Chess();
-    void makeMove(Move pieceMove);
+    bool makeMove(Move pieceMove);
     void undoMove();
-    uint64_t attacksToSquare(Square sq, Piece color);
-    inline void getMovesFromBB(MoveList &moveList, uint64_t bitboard, Square squareFrom, uint8_t flag);
-    MoveList getPseudoLegalMoves();
-    bool isLegal(Move move, Square kingSquare);
-    MoveList getLegalMoves();
+    template<Piece Us> void undoMoveFor();
     PerftResults perft(int depth);
     std::vector<Piece> getCurrentBoard(); // To do remove, pieceAt already covers this
     Piece getSquareColor(int sq);
     std::string getFen();
+    bool loadFen(const std::string &fen);
     Piece getPieceAt(Square from);
     #ifdef __EMSCRIPTEN__
     emscripten::val getLegalMovesAsJsArray();
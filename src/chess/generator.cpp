@@ -1,123 +1,146 @@
 #include "generator.h"
+#include <algorithm>
+#include <string>
+
+#ifdef PEXT_AVAILABLE
+#include <cpuid.h>
+#endif
+
+// Magic numbers found with a random search, valid for both the moveboards and the xrays of each square.
+constexpr SquareBoards ROOK_MAGICS = {
+    0x0080028840005320ULL, 0x3040002000100048ULL, 0x0100110040082000ULL, 0x0b000d0020100008ULL,
+    0x0200040802001120ULL, 0x0200080104820010ULL, 0x0880008021000200ULL, 0x4080005821000080ULL,
+    0x0000800020804000ULL, 0x0064400020005000ULL, 0x0405002003004010ULL, 0x0002000a00401020ULL,
+    0x1c02000a00041020ULL, 0x0002000408020010ULL, 0x0061000401000200ULL, 0x04448002f9000080ULL,
+    0x0080064004200042ULL, 0x0110094004482000ULL, 0x0001430011002002ULL, 0x8000828050000800ULL,
+    0x3086808004000800ULL, 0x0204004002010040ULL, 0x4040a40002210830ULL, 0x510002002884430cULL,
+    0x8084842880044000ULL, 0x1030400080200092ULL, 0x0001004100200010ULL, 0x3800080080100080ULL,
+    0x1300080080800400ULL, 0x0201000300082400ULL, 0x0801000900020014ULL, 0x000a004200009421ULL,
+    0x004040002880008cULL, 0x611010600a4002c0ULL, 0x2140284082001201ULL, 0x8008090021001000ULL,
+    0x0000040082800800ULL, 0x0320800200800400ULL, 0x000010080400c201ULL, 0x8010040b82000441ULL,
+    0x0040004020908000ULL, 0x80d0002010404004ULL, 0x0610002000848012ULL, 0x0004100300210008ULL,
+    0x0009804100100220ULL, 0x0000020004008080ULL, 0x2001080201040010ULL, 0x0008884500a20004ULL,
+    0x1840102040800080ULL, 0x8040834000200280ULL, 0x4001004214200500ULL, 0x0010002104081100ULL,
+    0x0008004004020040ULL, 0x0802001108041600ULL, 0x0002002447088200ULL, 0x9001800041000080ULL,
+    0x0800801420420102ULL, 0x0501088020104202ULL, 0x0000082004401101ULL, 0x00030128e0041001ULL,
+    0x801200091004a002ULL, 0x8402000804011002ULL, 0x8902100248008104ULL, 0x0000050442902402ULL
+};
+
+constexpr SquareBoards BISHOP_MAGICS = {
+    0x1082440808010024ULL, 0x0010121204242020ULL, 0x0390010622228000ULL, 0x0048622040020010ULL,
+    0x0002021000008044ULL, 0x0000821040000480ULL, 0x0840611008200000ULL, 0x0120822110222022ULL,
+    0x4800080801280202ULL, 0x1822050428020028ULL, 0x1105042102020001ULL, 0x04000c24048010c0ULL,
+    0x000201104100400aULL, 0x0000810482400200ULL, 0x000000412808c080ULL, 0x000080228834100cULL,
+    0x1360884008015500ULL, 0x1002001032080310ULL, 0x300100a2180a0081ULL, 0x00c3105804110002ULL,
+    0x0033000090400808ULL, 0x42018001480c4004ULL, 0x8282048108908401ULL, 0x0141850050441020ULL,
+    0x08024000a0080258ULL, 0x1001041248100440ULL, 0x040066000c0c0400ULL, 0x0062020808008008ULL,
+    0x0020808010082000ULL, 0x2040828041082001ULL, 0x0801004161141028ULL, 0x88444480410c0120ULL,
+    0x0881104048104404ULL, 0x0029101000824410ULL, 0x0014020800010044ULL, 0x0040200502080090ULL,
+    0x20810b0400220020ULL, 0x048210010002104bULL, 0x4001380120008400ULL, 0x0043121a22960900ULL,
+    0x0824100404081000ULL, 0x11020801050018b0ULL, 0x003200904c023802ULL, 0x0104a2221404c800ULL,
+    0x1d04016011000200ULL, 0x0012108122004302ULL, 0x9182100202000090ULL, 0x00d0016200200080ULL,
+    0x008080a808400100ULL, 0x8800908818120241ULL, 0x0020042108080000ULL, 0x8012801084044000ULL,
+    0x0800881202020084ULL, 0x081040a204044046ULL, 0x1820080121242000ULL, 0x0002100401105010ULL,
+    0x028080405004a000ULL, 0x000012006a121000ULL, 0x040410002c020800ULL, 0x0008014080420200ULL,
+    0x0000140020042409ULL, 0x05000004b0121212ULL, 0x0001910401080204ULL, 0x404001020c004089ULL
+};
+
+// Software version of pext, used to find entries of the pext order tables while they are generated.
+constexpr uint64_t extractBits(uint64_t src, uint64_t mask){
+    uint64_t result = 0;
+    int bitindex = 0;
 
-Generator::Generator(){
-    genPawnMoves();
-    genKnightMoves();
-    genKingMoves();
-    genPawnAttacks();
-    genRayMoves();
-    genRookMoves();
-    genBishopMoves();
-    genRookMoveboards();
-    genBishopMoveboards();
-    genRookXrays();
-    genBishopXrays();
-    std::cout << "Generator created" << std::endl;
-}
-
-int Generator::bitScanForward(uint64_t n){
-    if(n == 0) return -1;
-
-    int i = A1;
-    while((n >> i) % 2 == 0){
-        i++;
+    while(mask != 0){
+        uint64_t lowBit = mask & (0 - mask);
+        if(src & lowBit){
+            result |= (1ULL << bitindex);
+        }
+        bitindex++;
+        mask ^= lowBit;
     }
 
-    return i;
+    return result;
 }
 
-int Generator::bitScanReverse(uint64_t n){
-    if(n == 0) return -1;
+SliderBackend Generator::sliderBackend = Generator::detectSliderBackend();
 
-    int i = H8;
-    while((n >> i) % 2 == 0){
-        i--;
+SliderBackend Generator::detectSliderBackend(){
+    #ifdef PEXT_AVAILABLE
+    unsigned int eax, ebx, ecx, edx;
+    if(!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) || !(ebx & bit_BMI2)){
+        return MAGIC_BACKEND;
     }
 
-    return i;
-}
+    // AMD processors before Zen 3 (family 19h) implement pext in microcode, there magics are faster.
+    char vendor[13] = { 0 };
+    __get_cpuid(0, &eax, &ebx, &ecx, &edx);
+    std::copy((char*)&ebx, (char*)&ebx + 4, vendor);
+    std::copy((char*)&edx, (char*)&edx + 4, vendor + 4);
+    std::copy((char*)&ecx, (char*)&ecx + 4, vendor + 8);
 
-// Brian Kernighan algorithm to count the number of bits set on an integer.
-int Generator::bitCountSet(uint64_t n){
-    int counter = 0;
+    __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+    unsigned int family = ((eax >> 8) & 0xf) + ((eax >> 20) & 0xff);
 
-    while(n != 0){
-        n &= (n - 1);
-        counter++;
+    if(std::string(vendor) == "AuthenticAMD" && family < 0x19){
+        return MAGIC_BACKEND;
     }
 
-    return counter;
+    return PEXT_BACKEND;
+    #else
+    return MAGIC_BACKEND;
+    #endif
 }
 
-void Generator::genPawnMoves(){
+const char* Generator::getSliderBackendName(){
+    return sliderBackend == PEXT_BACKEND ? "pext" : "magic";
+}
+
+constexpr std::array<SquareBoards, 2> Generator::genPawnMoves(){
+    std::array<SquareBoards, 2> pawnMoves = {};
     // They are set with the predefined moves that are shifted for each square
-    uint64_t whiteMoves;
-    uint64_t blackMoves;
+    uint64_t whiteMoves = 256;
+    uint64_t blackMoves = 36028797018963968ULL;
 
     for(int i = 0; i < 64; i++){
-        whiteMoves = 256;
-        blackMoves = 36028797018963968;
-
         pawnMoves[WHITE][i] = whiteMoves << i;
         pawnMoves[BLACK][i] = blackMoves >> (63 - i);
     }
 
-    for(int i = A2; i <= H2; i++){
-        whiteMoves = 65792; 
-        uint64_t whiteDouble = 65536;
-
-        doublePawns[WHITE][i] = whiteMoves << i;
-        int bitLength = bitCountSet(doublePawns[WHITE][i]);
-
-        for(int j = 0; j < (1 << bitLength); j++){
-            uint64_t blockersBoard = genBlockerBoard(j, doublePawns[WHITE][i]);
-            uint8_t square = 0;
+    return pawnMoves;
+}
 
-            if(blockersBoard == 0) {
-                uint64_t finalSquare = whiteDouble << i;
-                square = __builtin_ctzll(finalSquare);
-            }
+constexpr std::array<SquareBoards, 2> Generator::genDoublePawns(){
+    std::array<SquareBoards, 2> doublePawns = {};
+    uint64_t whiteMoves = 65792;
+    uint64_t blackMoves = 36169534507319296ULL;
 
-            doublePawnMoveboard[i][blockersBoard] = square;
-        }
+    for(int i = A2; i <= H2; i++){
+        doublePawns[WHITE][i] = whiteMoves << i;
     }
 
     for(int i = A7; i <= H7; i++){
-        blackMoves = 36169534507319296;
-        uint64_t blackDouble = 140737488355328;
-
         doublePawns[BLACK][i] = blackMoves >> (63 - i);
-        int bitLength = bitCountSet(doublePawns[BLACK][i]);
-
-        for(int j = 0; j < (1 << bitLength); j++){
-            uint64_t blockersBoard = genBlockerBoard(j, doublePawns[BLACK][i]);
-            uint8_t square = 0;
-
-            if(blockersBoard == 0) {
-                uint64_t finalSquare = blackDouble >> (63 - i);
-                square = __builtin_ctzll(finalSquare);
-            }
-
-            doublePawnMoveboard[i][blockersBoard] = square;
-        }
     }
+
+    return doublePawns;
 }
 
-void Generator::genKnightMoves(){
+constexpr SquareBoards Generator::genKnightMoves(){
+    SquareBoards knightMoves = {};
     // Moves to be shifted, on the borders moves change.
-    uint64_t moves;
+    uint64_t moves = 0;
 
     for(int i = 0; i < 64; i++){
-        if(isAFile((Square)i)){
+        if(isAFile(i)){
             moves = 34628177928;
         }
-        else if(isBFile((Square)i)){
+        else if(isBFile(i)){
             moves = 43218112522;
         }
-        else if(isGFile((Square)i)){
+        else if(isGFile(i)){
             moves = 42966450442;
         }
-        else if(isHFile((Square)i)){
+        else if(isHFile(i)){
             moves = 8606712066;
         }
         else{
@@ -132,16 +155,19 @@ void Generator::genKnightMoves(){
             knightMoves[i] = moves >> (C3 - i);
         }
     }
+
+    return knightMoves;
 }
 
-void Generator::genKingMoves(){
-    uint64_t moves;
+constexpr SquareBoards Generator::genKingMoves(){
+    SquareBoards kingMoves = {};
+    uint64_t moves = 0;
 
     for(int i = 0; i < 64; i++){
-        if(isAFile((Square)i)){
+        if(isAFile(i)){
             moves = 394246;
         }
-        else if(isHFile((Square)i)){
+        else if(isHFile(i)){
             moves = 196867;
         }
         else{
@@ -156,18 +182,21 @@ void Generator::genKingMoves(){
             kingMoves[i] = moves >> (B2 - i);
         }
     }
+
+    return kingMoves;
 }
 
-void Generator::genPawnAttacks(){
-    uint64_t whiteMoves;
-    uint64_t blackMoves;
+constexpr std::array<SquareBoards, 2> Generator::genPawnAttacks(){
+    std::array<SquareBoards, 2> pawnAttacks = {};
+    uint64_t whiteMoves = 0;
+    uint64_t blackMoves = 0;
 
     for(int i = 0; i < 64; i++){
-        if(isAFile((Square)i)){
+        if(isAFile(i)){
             whiteMoves = 262144;
             blackMoves = 4;
         }
-        else if(isHFile((Square)i)){
+        else if(isHFile(i)){
             whiteMoves = 65536;
             blackMoves = 1;
         }
@@ -186,199 +215,309 @@ void Generator::genPawnAttacks(){
             pawnAttacks[BLACK][i] = blackMoves >> (B2 - i);
         }
     }
+
+    return pawnAttacks;
 }
 
-void Generator::genRayMoves(){
+constexpr RayBoards Generator::genRayMoves(){
+    RayBoards rayMoves = {};
+
     for(int i = 0; i < 64; i++){
         int sqFile = i % 8;
         int sqRank = i / 8;
 
-        rayMoves[i][NORTH] = 72340172838076672 << i;
-        rayMoves[i][SOUTH] = 36170086419038336 >> (63 - i);
+        rayMoves[i][NORTH] = 72340172838076672ULL << i;
+        rayMoves[i][SOUTH] = 36170086419038336ULL >> (63 - i);
 
         // For the sides we do 2^file(or 7 - file for east) and subtract 1 so all the bits before the power are set,
-        // then we shift square with and offset.
-        rayMoves[i][EAST] = (1 << (7 - sqFile)) - 1;
-        rayMoves[i][EAST] <<= (i + 1);
-        rayMoves[i][WEST] = (1 << sqFile) - 1;
+        // then we shift square with and offset. H8 has no east ray, and shifting it by 64 is undefined.
+        rayMoves[i][EAST] = (1ULL << (7 - sqFile)) - 1;
+        rayMoves[i][EAST] = (i < 63) ? (rayMoves[i][EAST] << (i + 1)) : 0;
+        rayMoves[i][WEST] = (1ULL << sqFile) - 1;
         rayMoves[i][WEST] <<= (i - sqFile);
 
         // Has all 64 bit set. Is used to clear the extra bits after shifting diagonals.
-        uint64_t mask = 18446744073709551615U;
-        int maskShift;
+        uint64_t mask = 18446744073709551615ULL;
+        int maskShift = 0;
 
-        uint64_t neRay = 9241421688590303744U << i;
+        uint64_t neRay = 9241421688590303744ULL << i;
         maskShift = 8*(sqFile - sqRank);
         if(maskShift < 0) { maskShift = 0; }
         rayMoves[i][NORTH_EAST] = (mask >> maskShift) & neRay;
 
-        uint64_t nwRay = 567382630219904 << i;
+        uint64_t nwRay = 567382630219904ULL << i;
         maskShift = 8*(7 - sqFile - sqRank) + 1;
         if(maskShift < 0) { maskShift = 0; }
         rayMoves[i][NORTH_WEST] = (mask >> maskShift) & nwRay;
 
-        uint64_t seRay = 72624976668147712 >> (63 - i);
+        uint64_t seRay = 72624976668147712ULL >> (63 - i);
         maskShift = 8*(-7 + sqFile + sqRank) + 1;
         if(maskShift < 0) { maskShift = 0;}
         rayMoves[i][SOUTH_EAST] = (mask << maskShift) & seRay;
 
-        uint64_t swRay = 18049651735527937 >> (63 - i);
+        uint64_t swRay = 18049651735527937ULL >> (63 - i);
         maskShift = 8*(-sqFile + sqRank);
         if(maskShift < 0) { maskShift = 0; }
         rayMoves[i][SOUTH_WEST] = (mask << maskShift) & swRay;
     }
+
+    return rayMoves;
 }
 
-void Generator::genRookMoves(){
+constexpr SquareBoards Generator::genRookMoves(const RayBoards &rays){
+    SquareBoards rookMoves = {};
+
     // We remove the borders at the end to reduce unnecessary mappings later, but we must do it individually
     // for each side.
     for(int i = 0; i < 64; i++){
-        uint64_t northMoves = 72057594037927935U & rayMoves[i][NORTH];
-        uint64_t southMoves = 18446744073709551360U & rayMoves[i][SOUTH];
-        uint64_t westMoves = 18374403900871474942U & rayMoves[i][WEST];
-        uint64_t eastMoves = 9187201950435737471U & rayMoves[i][EAST];
+        uint64_t northMoves = 72057594037927935ULL & rays[i][NORTH];
+        uint64_t southMoves = 18446744073709551360ULL & rays[i][SOUTH];
+        uint64_t westMoves = 18374403900871474942ULL & rays[i][WEST];
+        uint64_t eastMoves = 9187201950435737471ULL & rays[i][EAST];
 
         rookMoves[i] = northMoves | southMoves | westMoves | eastMoves;
     }
+
+    return rookMoves;
 }
 
-void Generator::genBishopMoves(){
+constexpr SquareBoards Generator::genBishopMoves(const RayBoards &rays){
+    SquareBoards bishopMoves = {};
+
     // We remove the borders at the end to reduce unnecessary mappings later.
     for(int i = 0; i < 64; i++){
-        bishopMoves[i] = (rayMoves[i][NORTH_WEST] | rayMoves[i][NORTH_EAST] |
-                            rayMoves[i][SOUTH_WEST] | rayMoves[i][SOUTH_EAST]) & 35604928818740736;
+        bishopMoves[i] = (rays[i][NORTH_WEST] | rays[i][NORTH_EAST] |
+                            rays[i][SOUTH_WEST] | rays[i][SOUTH_EAST]) & 35604928818740736ULL;
     }
+
+    return bishopMoves;
 }
 
-// Generates a unique blockerboard with an index and either a rook or bishop moveboard(without blockers).
-// The number of indexes is determined by the number of bits set in the moveboard, so 2^bits blockerboards.
-uint64_t Generator::genBlockerBoard(int index, uint64_t rayMask){
-    int bitindex = 0;
-    uint64_t j = 1;
+// Opposite of each direction, in the same order as the Direction enum
+constexpr int OPPOSITE_DIRECTION[8] = {SOUTH, WEST, SOUTH_WEST, SOUTH_EAST, NORTH, EAST, NORTH_WEST, NORTH_EAST};
 
-    for(int i = 0; i < 64; i++){
-        if((rayMask & (j << i)) != 0){
-            if((index & (j << bitindex)) == 0){
-                rayMask &= ~(j << i);
+constexpr SquarePairBoards Generator::genBetweenBoards(const RayBoards &rays){
+    SquarePairBoards betweenBoards = {};
+
+    // For every square in a ray the squares between are the ray minus the same ray starting from that square.
+    for(int from = 0; from < 64; from++){
+        for(int dir = NORTH; dir <= SOUTH_WEST; dir++){
+            uint64_t ray = rays[from][dir];
+
+            while(ray){
+                int to = bitScanForward(ray);
+                ray &= ray - 1;
+
+                betweenBoards[from][to] = rays[from][dir] & ~rays[to][dir] & ~(1ULL << to);
             }
-            bitindex += 1;
         }
     }
 
-    return rayMask;
+    return betweenBoards;
 }
 
-// Create the mapping for the final rook moveboards
-void Generator::genRookMoveboards(){
-    for(int i = 0; i < 64; i++){
-        int bitLength = bitCountSet(rookMoves[i]);
+constexpr SquarePairBoards Generator::genLineBoards(const RayBoards &rays){
+    SquarePairBoards lineBoards = {};
 
-        // The number of blockers combinations is 2 to the power of the bit count.
-        // Once with have the blockers board we check for the first blocker in each direction and remove the bits afterwards.
-        for(int j = 0; j < (1 << bitLength); j++){
-            uint64_t blockersBoard = genBlockerBoard(j, rookMoves[i]);
-            uint64_t moveboard = rayMoves[i][NORTH] | rayMoves[i][SOUTH] | rayMoves[i][WEST] | rayMoves[i][EAST];
-            uint64_t northBlocker, southBlocker, westBlocker, eastBlocker;
+    for(int from = 0; from < 64; from++){
+        for(int dir = NORTH; dir <= SOUTH_WEST; dir++){
+            uint64_t line = rays[from][dir] | rays[from][OPPOSITE_DIRECTION[dir]] | (1ULL << from);
+            uint64_t ray = rays[from][dir];
 
-            if((northBlocker = (rayMoves[i][NORTH] & blockersBoard)) > 0){
-                moveboard ^= rayMoves[bitScanForward(northBlocker)][NORTH];
-            }
-            if((southBlocker = (rayMoves[i][SOUTH] & blockersBoard)) > 0){
-                moveboard ^= rayMoves[bitScanReverse(southBlocker)][SOUTH];
-            }
-            if((westBlocker = (rayMoves[i][WEST] & blockersBoard)) > 0){
-                moveboard ^= rayMoves[bitScanReverse(westBlocker)][WEST];
-            }
-            if((eastBlocker = (rayMoves[i][EAST] & blockersBoard)) > 0){
-                moveboard ^= rayMoves[bitScanForward(eastBlocker)][EAST];
+            while(ray){
+                int to = bitScanForward(ray);
+                ray &= ray - 1;
+
+                lineBoards[from][to] = line;
             }
+        }
+    }
+
+    return lineBoards;
+}
 
-            rookMoveboard[i][blockersBoard] = moveboard;
+// Generates a unique blockerboard with an index and either a rook or bishop moveboard(without blockers).
+// The number of indexes is determined by the number of bits set in the moveboard, so 2^bits blockerboards.
+// The bits of the index are placed on the bits of the moveboard, from the least significant one.
+constexpr uint64_t Generator::genBlockerBoard(int index, uint64_t rayMask){
+    uint64_t blockers = 0;
+
+    while(rayMask != 0){
+        uint64_t lowBit = rayMask & (0 - rayMask);
+        if(index & 1){
+            blockers |= lowBit;
         }
+        index >>= 1;
+        rayMask ^= lowBit;
     }
+
+    return blockers;
 }
 
-void Generator::genBishopMoveboards(){
+constexpr std::array<uint32_t, 64> Generator::genSliderOffsets(const SquareBoards &masks){
+    std::array<uint32_t, 64> offsets = {};
+    uint32_t offset = 0;
+
     for(int i = 0; i < 64; i++){
-        int bitLength = bitCountSet(bishopMoves[i]);
+        offsets[i] = offset;
+        offset += (1U << bitCountSet(masks[i]));
+    }
 
-        // The number of blockers combinations is 2 to the power of the bit count.
-        // Once with have the blockers board we check for the first blocker in each direction and remove the bits afterwards.
-        for(int j = 0; j < (1 << bitLength); j++){
-            uint64_t blockersBoard = genBlockerBoard(j, bishopMoves[i]);
-            uint64_t moveboard = rayMoves[i][NORTH_WEST] | rayMoves[i][NORTH_EAST] | rayMoves[i][SOUTH_WEST] | rayMoves[i][SOUTH_EAST];
-            uint64_t nwestBlocker, neastBlocker, swestBlocker, seastBlocker;
+    return offsets;
+}
 
-            if((nwestBlocker = (rayMoves[i][NORTH_WEST] & blockersBoard)) > 0){
-                moveboard ^= rayMoves[bitScanForward(nwestBlocker)][NORTH_WEST];
-            }
-            if((neastBlocker = (rayMoves[i][NORTH_EAST] & blockersBoard)) > 0){
-                moveboard ^= rayMoves[bitScanForward(neastBlocker)][NORTH_EAST];
-            }
-            if((swestBlocker = (rayMoves[i][SOUTH_WEST] & blockersBoard)) > 0){
-                moveboard ^= rayMoves[bitScanReverse(swestBlocker)][SOUTH_WEST];
-            }
-            if((seastBlocker = (rayMoves[i][SOUTH_EAST] & blockersBoard)) > 0){
-                moveboard ^= rayMoves[bitScanReverse(seastBlocker)][SOUTH_EAST];
-            }
+constexpr std::array<uint8_t, 64> Generator::genSliderShifts(const SquareBoards &masks){
+    std::array<uint8_t, 64> shifts = {};
 
-            bishopMoveboard[i][blockersBoard] = moveboard;
-        }
+    for(int i = 0; i < 64; i++){
+        shifts[i] = (uint8_t)(64 - bitCountSet(masks[i]));
     }
+
+    return shifts;
 }
 
-void Generator::genRookXrays(){
-    for(int i = 0; i < 64; i++){
-        int bitLength = bitCountSet(rookMoves[i]);
+// Create the moveboards and xrays of a slider for every blockers combination. The blockers are enumerated with the
+// carry rippler trick, (blockers - mask) & mask gives the next one in the same order as genBlockerBoard.
+template<int Size>
+constexpr SliderTables<Size> Generator::genSliderTables(const RayBoards &rays, const SquareBoards &masks,
+    const std::array<uint32_t, 64> &offsets, bool rook){
+    SliderTables<Size> tables = {};
+
+    // The first two directions grow to the most significant bit, so the first blocker is found with a forward scan.
+    int directions[4] = { NORTH, EAST, SOUTH, WEST };
+    if(!rook){
+        directions[0] = NORTH_EAST;
+        directions[1] = NORTH_WEST;
+        directions[2] = SOUTH_EAST;
+        directions[3] = SOUTH_WEST;
+    }
 
-        for(int j = 0; j < (1 << bitLength); j++){
-            // AND to obtain only the first blockers in each direction
-            uint64_t blockersBoard = genBlockerBoard(j, rookMoves[i]);
-            uint64_t firstBlockers = blockersBoard & rookMoveboard[i][blockersBoard];
-            uint64_t xrayMoves = 0;
+    for(int i = 0; i < 64; i++){
+        uint64_t squareRays[4] = { rays[i][directions[0]], rays[i][directions[1]], rays[i][directions[2]], rays[i][directions[3]] };
+        uint64_t emptyMoveboard = squareRays[0] | squareRays[1] | squareRays[2] | squareRays[3];
+        uint64_t mask = masks[i];
+        uint64_t blockersBoard = 0;
+        uint32_t index = offsets[i];
 
-            while(firstBlockers > 0){
-                int blocker = bitScanForward(firstBlockers);
-                // Create a new blockers board with only the blockers of one direction
-                uint64_t newBlockers = blockersBoard & rookMoves[blocker];
-                // Create xray to the next blocker
-                uint64_t newRay = rookMoveboard[i][0] & (~rookMoveboard[i][blockersBoard]);
-                newRay &= rookMoveboard[blocker][newBlockers];
-                // We add it to the other rays
-                xrayMoves |= newRay;
-                // After we get the ray we clear the bit (the 1 most be uint64)
-                uint64_t k = 1;
-                firstBlockers ^= (k << blocker);
+        // Once with have the blockers board we check for the first blocker in each direction and remove the bits afterwards.
+        do {
+            uint64_t moveboard = emptyMoveboard;
+
+            for(int d = 0; d < 4; d++){
+                uint64_t blocker = squareRays[d] & blockersBoard;
+                if(blocker > 0){
+                    int blockerSq = d < 2 ? __builtin_ctzll(blocker) : 63 - __builtin_clzll(blocker);
+                    moveboard ^= rays[blockerSq][directions[d]];
+                }
             }
-            rookXrays[i][blockersBoard] = xrayMoves;
-        }
+
+            tables.moveboard[index++] = moveboard;
+            blockersBoard = (blockersBoard - mask) & mask;
+        } while(blockersBoard != 0);
     }
-}
 
-void Generator::genBishopXrays(){
     for(int i = 0; i < 64; i++){
-        int bitLength = bitCountSet(bishopMoves[i]);
+        uint64_t mask = masks[i];
+        uint64_t emptyMoveboard = tables.moveboard[offsets[i]];
+        uint64_t blockersBoard = 0;
+        uint32_t index = offsets[i];
 
-        for(int j = 0; j < (1 << bitLength); j++){
+        do {
             // AND to obtain only the first blockers in each direction
-            uint64_t blockersBoard = genBlockerBoard(j, bishopMoves[i]);
-            uint64_t firstBlockers = blockersBoard & bishopMoveboard[i][blockersBoard];
+            uint64_t moveboard = tables.moveboard[index];
+            uint64_t firstBlockers = blockersBoard & moveboard;
             uint64_t xrayMoves = 0;
 
             while(firstBlockers > 0){
-                int blocker = bitScanForward(firstBlockers);
+                int blocker = __builtin_ctzll(firstBlockers);
                 // Create a new blockers board with only the blockers of one direction
-                uint64_t newBlockers = blockersBoard & bishopMoves[blocker];
+                uint64_t newBlockers = blockersBoard & masks[blocker];
                 // Create xray to the next blocker
-                uint64_t newRay = bishopMoveboard[i][0] & (~bishopMoveboard[i][blockersBoard]);
-                newRay &= bishopMoveboard[blocker][newBlockers];
+                uint64_t newRay = emptyMoveboard & (~moveboard);
+                newRay &= tables.moveboard[offsets[blocker] + extractBits(newBlockers, masks[blocker])];
                 // We add it to the other rays
                 xrayMoves |= newRay;
-                // After we get the ray we clear the bit (the 1 most be uint64)
-                uint64_t k = 1;
-                firstBlockers ^= (k << blocker);
+                // After we get the ray we clear the bit
+                firstBlockers &= firstBlockers - 1;
             }
-            bishopXrays[i][blockersBoard] = xrayMoves;
-        }
+
+            tables.xrays[index++] = xrayMoves;
+            blockersBoard = (blockersBoard - mask) & mask;
+        } while(blockersBoard != 0);
     }
+
+    return tables;
 }
+
+// Places every entry of the pext order tables in its magic index.
+template<int Size>
+constexpr SliderTables<Size> Generator::genMagicTables(const SliderTables<Size> &pextTables, const SquareBoards &masks,
+    const std::array<uint32_t, 64> &offsets, const std::array<uint8_t, 64> &shifts, const SquareBoards &magics){
+    SliderTables<Size> magicTables = {};
+
+    for(int i = 0; i < 64; i++){
+        uint64_t mask = masks[i];
+        uint64_t magic = magics[i];
+        int shift = shifts[i];
+        uint32_t offset = offsets[i];
+        uint32_t index = offset;
+        uint64_t blockersBoard = 0;
+
+        do {
+            uint32_t magicIndex = offset + (uint32_t)((blockersBoard * magic) >> shift);
+            magicTables.moveboard[magicIndex] = pextTables.moveboard[index];
+            magicTables.xrays[magicIndex] = pextTables.xrays[index];
+            index++;
+            blockersBoard = (blockersBoard - mask) & mask;
+        } while(blockersBoard != 0);
+    }
+
+    return magicTables;
+}
+
+// All the tables are evaluated here at compile time, the constexpr variables force it and are not emitted.
+constexpr RayBoards RAY_MOVES = Generator::genRayMoves();
+constexpr SquareBoards ROOK_MOVES = Generator::genRookMoves(RAY_MOVES);
+constexpr SquareBoards BISHOP_MOVES = Generator::genBishopMoves(RAY_MOVES);
+constexpr SquarePairBoards BETWEEN_BOARDS = Generator::genBetweenBoards(RAY_MOVES);
+constexpr SquarePairBoards LINE_BOARDS = Generator::genLineBoards(RAY_MOVES);
+constexpr std::array<uint32_t, 64> ROOK_OFFSETS = Generator::genSliderOffsets(ROOK_MOVES);
+constexpr std::array<uint32_t, 64> BISHOP_OFFSETS = Generator::genSliderOffsets(BISHOP_MOVES);
+constexpr std::array<uint8_t, 64> ROOK_SHIFTS = Generator::genSliderShifts(ROOK_MOVES);
+constexpr std::array<uint8_t, 64> BISHOP_SHIFTS = Generator::genSliderShifts(BISHOP_MOVES);
+
+constexpr SliderTables<ROOK_TABLE_SIZE> ROOK_TABLES =
+    Generator::genSliderTables<ROOK_TABLE_SIZE>(RAY_MOVES, ROOK_MOVES, ROOK_OFFSETS, true);
+constexpr SliderTables<BISHOP_TABLE_SIZE> BISHOP_TABLES =
+    Generator::genSliderTables<BISHOP_TABLE_SIZE>(RAY_MOVES, BISHOP_MOVES, BISHOP_OFFSETS, false);
+
+constexpr SliderTables<ROOK_TABLE_SIZE> ROOK_MAGIC_TABLES =
+    Generator::genMagicTables<ROOK_TABLE_SIZE>(ROOK_TABLES, ROOK_MOVES, ROOK_OFFSETS, ROOK_SHIFTS, ROOK_MAGICS);
+constexpr SliderTables<BISHOP_TABLE_SIZE> BISHOP_MAGIC_TABLES =
+    Generator::genMagicTables<BISHOP_TABLE_SIZE>(BISHOP_TABLES, BISHOP_MOVES, BISHOP_OFFSETS, BISHOP_SHIFTS, BISHOP_MAGICS);
+
+const std::array<SquareBoards, 2> Generator::pawnMoves = Generator::genPawnMoves();
+const SquareBoards Generator::knightMoves = Generator::genKnightMoves();
+const SquareBoards Generator::kingMoves = Generator::genKingMoves();
+const std::array<SquareBoards, 2> Generator::pawnAttacks = Generator::genPawnAttacks();
+const std::array<SquareBoards, 2> Generator::doublePawns = Generator::genDoublePawns();
+const RayBoards Generator::rayMoves = RAY_MOVES;
+const SquareBoards Generator::rookMoves = ROOK_MOVES;
+const SquareBoards Generator::bishopMoves = BISHOP_MOVES;
+const SquarePairBoards Generator::betweenBoards = BETWEEN_BOARDS;
+const SquarePairBoards Generator::lineBoards = LINE_BOARDS;
+
+const SquareBoards Generator::rookMagics = ROOK_MAGICS;
+const SquareBoards Generator::bishopMagics = BISHOP_MAGICS;
+const std::array<uint32_t, 64> Generator::rookOffsets = ROOK_OFFSETS;
+const std::array<uint32_t, 64> Generator::bishopOffsets = BISHOP_OFFSETS;
+const std::array<uint8_t, 64> Generator::rookShifts = ROOK_SHIFTS;
+const std::array<uint8_t, 64> Generator::bishopShifts = BISHOP_SHIFTS;
+
+const SliderTables<ROOK_TABLE_SIZE> Generator::rookTables = ROOK_MAGIC_TABLES;
+const SliderTables<BISHOP_TABLE_SIZE> Generator::bishopTables = BISHOP_MAGIC_TABLES;
+
+#ifdef PEXT_AVAILABLE
+const SliderTables<ROOK_TABLE_SIZE> Generator::rookPextTables = ROOK_TABLES;
+const SliderTables<BISHOP_TABLE_SIZE> Generator::bishopPextTables = BISHOP_TABLES;
+#endif
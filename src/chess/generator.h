@@ -1,72 +1,219 @@
 #ifndef __GENERATOR__
 #define __GENERATOR__
 #include <cstdint>
-#include <unordered_map>
-#include <iostream>
+#include <array>
+#include <type_traits>
 
 #include "move_structs.h"
 
-// The generator class is use to initialize all the useful data for fast move generation
+// The pext backend needs BMI2 instructions, it is only compiled for x86-64. The WASM build and other
+// architectures always use magic bitboards.
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(__EMSCRIPTEN__) && !defined(NO_PEXT)
+#define PEXT_AVAILABLE
+#endif
+
+// Indexing used for the slider tables, picked once at startup.
+enum SliderBackend : uint8_t {
+    MAGIC_BACKEND,
+    PEXT_BACKEND
+};
+
+#ifdef PEXT_AVAILABLE
+// Parallel bit extract, only called when the CPU reported BMI2 support. Inline assembly is used instead of the
+// intrinsic so it can be inlined in code compiled without -mbmi2.
+inline uint64_t pext(uint64_t src, uint64_t mask){
+    uint64_t result;
+    asm("pextq %2, %1, %0" : "=r"(result) : "r"(src), "r"(mask));
+    return result;
+}
+#endif
+
+// Size of the flat slider tables, each square owns 2^(relevant blockers) consecutive entries.
+const int ROOK_TABLE_SIZE = 102400;
+const int BISHOP_TABLE_SIZE = 5248;
+
+// One bitboard for each square
+typedef std::array<uint64_t, 64> SquareBoards;
+typedef std::array<std::array<uint64_t, 8>, 64> RayBoards;
+// One bitboard for each pair of squares
+typedef std::array<SquareBoards, 64> SquarePairBoards;
+
+// Flat moveboards and xrays of a slider, indexed by square offset plus the magic or pext index of the blockers.
+// Plain arrays are used because they are much faster than std::array to evaluate at compile time.
+template<int Size>
+struct SliderTables {
+    uint64_t moveboard[Size];
+    uint64_t xrays[Size];
+};
+
+// The generator class contains all the useful data for fast move generation. Every table is computed at compile
+// time in generator.cpp, so there is nothing to initialize at startup. All the data is static and read-only, the
+// same tables are shared by every Chess instance and every thread.
 class Generator{
 public:
     // Moves that dont consider blockers
-    uint64_t pawnMoves[2][64];
-    uint64_t knightMoves[64];
-    uint64_t kingMoves[64];
-    uint64_t pawnAttacks[2][64];
+    static const std::array<SquareBoards, 2> pawnMoves;
+    static const SquareBoards knightMoves;
+    static const SquareBoards kingMoves;
+    static const std::array<SquareBoards, 2> pawnAttacks;
 
-    // Double pawn moves
-    uint64_t doublePawns[2][64] = { 0 };
-    std::unordered_map<uint64_t, uint8_t> doublePawnMoveboard[64];
+    // Double pawn moves, both squares in front of the pawn must be empty
+    static const std::array<SquareBoards, 2> doublePawns;
 
     // Contains directional rays from all squares without blockers
-    uint64_t rayMoves[64][8];
+    static const RayBoards rayMoves;
 
     // Contains rook and bishop moves create with the rays. The moves at the edge of the board are not used.
-    uint64_t rookMoves[64];
-    uint64_t bishopMoves[64];
+    static const SquareBoards rookMoves;
+    static const SquareBoards bishopMoves;
+
+    // Squares strictly between two squares on the same line or diagonal, and the whole line that goes through them.
+    // Both are empty if the squares are not aligned. Used for check blocks and pinned pieces.
+    static const SquarePairBoards betweenBoards;
+    static const SquarePairBoards lineBoards;
 
-    // This maps have as index the bitboard resulting from & operation between the moveboard and the blockerboard.
-    // Then returns the bitboard with the allowed moves. Captures and friendly pieces are filtered afterwards.
-    std::unordered_map<uint64_t, uint64_t> rookMoveboard[64];
-    std::unordered_map<uint64_t, uint64_t> bishopMoveboard[64];
+    // Magic numbers that hash the blockers of a square (moveboard & occupied) into its slice of the flat tables,
+    // the slice starts at the square offset and the index is (blockers * magic) >> shift.
+    static const SquareBoards rookMagics;
+    static const SquareBoards bishopMagics;
+    static const std::array<uint32_t, 64> rookOffsets;
+    static const std::array<uint32_t, 64> bishopOffsets;
+    static const std::array<uint8_t, 64> rookShifts;
+    static const std::array<uint8_t, 64> bishopShifts;
 
-    // This maps work in a similar way to moveboards, but instead consider the moves after the first blocker.
+    // The moveboards have as index the magic index of the blockers of a square, and return the bitboard with the
+    // allowed moves. Captures and friendly pieces are filtered afterwards.
+    // The xrays work in a similar way to moveboards, but instead consider the moves after the first blocker.
     // They are used to check for absolute pins.
-    std::unordered_map<uint64_t, uint64_t> rookXrays[64];
-    std::unordered_map<uint64_t, uint64_t> bishopXrays[64];
+    static const SliderTables<ROOK_TABLE_SIZE> rookTables;
+    static const SliderTables<BISHOP_TABLE_SIZE> bishopTables;
 
-    // Constructor calls all the generation methods
-    Generator();
+    #ifdef PEXT_AVAILABLE
+    // Same tables for the pext backend. The index is pext(occupied, moveboard), so the blockers of a square are in
+    // the same order as genBlockerBoard generates them.
+    static const SliderTables<ROOK_TABLE_SIZE> rookPextTables;
+    static const SliderTables<BISHOP_TABLE_SIZE> bishopPextTables;
+    #endif
+
+    // Both backends have their tables ready at compile time, so lookups are valid even before it is selected.
+    static SliderBackend sliderBackend;
 
     // Search the index of least and most significant bit respectively
-    int bitScanForward(uint64_t n);
-    int bitScanReverse(uint64_t n);
-    // Returns the number of bit set for some number
-    int bitCountSet(uint64_t n);
+    static constexpr int bitScanForward(uint64_t n){
+        if(n == 0) return -1;
+
+        int i = A1;
+        while((n >> i) % 2 == 0){
+            i++;
+        }
+
+        return i;
+    }
+    static constexpr int bitScanReverse(uint64_t n){
+        if(n == 0) return -1;
+
+        int i = H8;
+        while((n >> i) % 2 == 0){
+            i--;
+        }
+
+        return i;
+    }
+    // Brian Kernighan algorithm to count the number of bits set on an integer.
+    static constexpr int bitCountSet(uint64_t n){
+        int counter = 0;
+
+        while(n != 0){
+            n &= (n - 1);
+            counter++;
+        }
+
+        return counter;
+    }
+
+    // Index of the blockers inside the flat slider tables
+    inline uint32_t rookIndex(int sq, uint64_t occupied) const {
+        return rookOffsets[sq] + (uint32_t)(((occupied & rookMoves[sq]) * rookMagics[sq]) >> rookShifts[sq]);
+    }
+    inline uint32_t bishopIndex(int sq, uint64_t occupied) const {
+        return bishopOffsets[sq] + (uint32_t)(((occupied & bishopMoves[sq]) * bishopMagics[sq]) >> bishopShifts[sq]);
+    }
+
+    #ifdef PEXT_AVAILABLE
+    inline uint32_t rookPextIndex(int sq, uint64_t occupied) const {
+        return rookOffsets[sq] + (uint32_t)pext(occupied, rookMoves[sq]);
+    }
+    inline uint32_t bishopPextIndex(int sq, uint64_t occupied) const {
+        return bishopOffsets[sq] + (uint32_t)pext(occupied, bishopMoves[sq]);
+    }
+    #endif
+
+    // Slider moves for a square given the occupied board, blockers outside the moveboard are ignored.
+    inline uint64_t getRookMoveboard(int sq, uint64_t occupied) const {
+        #ifdef PEXT_AVAILABLE
+        if(sliderBackend == PEXT_BACKEND) return rookPextTables.moveboard[rookPextIndex(sq, occupied)];
+        #endif
+        return rookTables.moveboard[rookIndex(sq, occupied)];
+    }
+    inline uint64_t getBishopMoveboard(int sq, uint64_t occupied) const {
+        #ifdef PEXT_AVAILABLE
+        if(sliderBackend == PEXT_BACKEND) return bishopPextTables.moveboard[bishopPextIndex(sq, occupied)];
+        #endif
+        return bishopTables.moveboard[bishopIndex(sq, occupied)];
+    }
+    inline uint64_t getRookXrays(int sq, uint64_t occupied) const {
+        #ifdef PEXT_AVAILABLE
+        if(sliderBackend == PEXT_BACKEND) return rookPextTables.xrays[rookPextIndex(sq, occupied)];
+        #endif
+        return rookTables.xrays[rookIndex(sq, occupied)];
+    }
+    inline uint64_t getBishopXrays(int sq, uint64_t occupied) const {
+        #ifdef PEXT_AVAILABLE
+        if(sliderBackend == PEXT_BACKEND) return bishopPextTables.xrays[bishopPextIndex(sq, occupied)];
+        #endif
+        return bishopTables.xrays[bishopIndex(sq, occupied)];
+    }
+
+    // Checks with CPUID if pext is supported and fast, otherwise magic bitboards are used.
+    static SliderBackend detectSliderBackend();
+    static const char* getSliderBackendName();
 
     // Utility functions to check relevant files(columns in chess)
-    bool isAFile(Square square){ return square % 8 == 0; }
-    bool isBFile(Square square){ return (square - 1) % 8 == 0; }
-    bool isGFile(Square square){ return (square + 2) % 8 == 0; }
-    bool isHFile(Square square){ return (square + 1) % 8 == 0; }
-
-    // Generation of the most basic moves for each pieces. Ray moves must initialize before rook and bishop.
-    void genPawnMoves();
-    void genKnightMoves();
-    void genKingMoves();
-    void genPawnAttacks();
-    void genRayMoves();
-    void genRookMoves();
-    void genBishopMoves();
+    static constexpr bool isAFile(int square){ return square % 8 == 0; }
+    static constexpr bool isBFile(int square){ return (square - 1) % 8 == 0; }
+    static constexpr bool isGFile(int square){ return (square + 2) % 8 == 0; }
+    static constexpr bool isHFile(int square){ return (square + 1) % 8 == 0; }
+
+    // Generation of the most basic moves for each pieces, only evaluated at compile time. Ray moves are used to
+    // create the rook and bishop moves.
+    static constexpr std::array<SquareBoards, 2> genPawnMoves();
+    static constexpr std::array<SquareBoards, 2> genDoublePawns();
+    static constexpr SquareBoards genKnightMoves();
+    static constexpr SquareBoards genKingMoves();
+    static constexpr std::array<SquareBoards, 2> genPawnAttacks();
+    static constexpr RayBoards genRayMoves();
+    static constexpr SquareBoards genRookMoves(const RayBoards &rays);
+    static constexpr SquareBoards genBishopMoves(const RayBoards &rays);
+    static constexpr SquarePairBoards genBetweenBoards(const RayBoards &rays);
+    static constexpr SquarePairBoards genLineBoards(const RayBoards &rays);
 
     // Generates a unique blockerboard with an index and either a rook or bishop moveboard(without blockers).
     // The number of indexes is determined by the number of 1 bits in the moveboard.
-    uint64_t genBlockerBoard(int index, uint64_t rayMask);
+    static constexpr uint64_t genBlockerBoard(int index, uint64_t rayMask);
 
-    void genRookMoveboards();
-    void genBishopMoveboards();
-    void genRookXrays();
-    void genBishopXrays();
+    // Assigns to each square its shift and slice of the flat tables
+    static constexpr std::array<uint32_t, 64> genSliderOffsets(const SquareBoards &masks);
+    static constexpr std::array<uint8_t, 64> genSliderShifts(const SquareBoards &masks);
+
+    // Moveboards and xrays in pext order, the magic tables are a permutation of them.
+    template<int Size>
+    static constexpr SliderTables<Size> genSliderTables(const RayBoards &rays, const SquareBoards &masks,
+        const std::array<uint32_t, 64> &offsets, bool rook);
+    template<int Size>
+    static constexpr SliderTables<Size> genMagicTables(const SliderTables<Size> &pextTables, const SquareBoards &masks,
+        const std::array<uint32_t, 64> &offsets, const std::array<uint8_t, 64> &shifts, const SquareBoards &magics);
 };
+
+// Chess instances get copied for every search and perft thread, the generator must not add any per instance data.
+static_assert(std::is_empty<Generator>::value, "Generator tables must be static");
 #endif // __GENERATOR__
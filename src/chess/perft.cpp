@@ -0,0 +1,230 @@
+#include "perft.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+PerftTable::PerftTable(size_t sizeMB){
+    // Round down to a power of 2 so the index is a mask of the key
+    size_t count = 1;
+    while(count * 2 * sizeof(PerftEntry) <= sizeMB * 1024 * 1024){
+        count *= 2;
+    }
+
+    entries.resize(count);
+    mask = count - 1;
+}
+
+bool PerftTable::probe(uint64_t key, int depth, uint64_t &count){
+    const PerftEntry &entry = entries[key & mask];
+
+    if(entry.key == key && (entry.data & 0xff) == (uint64_t)depth){
+        count = entry.data >> 8;
+        return true;
+    }
+
+    return false;
+}
+
+void PerftTable::store(uint64_t key, int depth, uint64_t count){
+    PerftEntry &entry = entries[key & mask];
+    entry.key = key;
+    entry.data = (count << 8) | (uint64_t)depth;
+}
+
+uint64_t perftBulk(Chess &chess, int depth, PerftTable *table){
+    if(depth == 0) return 1;
+    // No room left in the history for the whole tree
+    if(chess.totalMoves + depth > MAX_HISTORY) return perftCopyMake(chess, depth);
+
+    MoveList moves;
+    chess.generateMoves(moves, GEN_ALL);
+
+    if(depth == 1) {
+        return moves.count;
+    }
+
+    uint64_t nodes = 0;
+    if(table) {
+        if(table->probe(chess.key, depth, nodes)) {
+            return nodes;
+        }
+    }
+
+    for(Move m : moves) {
+        chess.makeMove(m);
+        nodes += perftBulk(chess, depth - 1, table);
+        chess.undoMove();
+    }
+
+    if(table) {
+        table->store(chess.key, depth, nodes);
+    }
+
+    return nodes;
+}
+
+uint64_t perftCopyMake(const Position &position, int depth){
+    if(depth == 0) return 1;
+
+    Position current = position;
+    MoveList moves;
+    current.generateMoves(moves, GEN_ALL);
+
+    if(depth == 1) {
+        return moves.count;
+    }
+
+    uint64_t nodes = 0;
+    for(Move m : moves) {
+        Position next = current;
+        next.applyMove(m);
+        nodes += perftCopyMake(next, depth - 1);
+    }
+
+    return nodes;
+}
+
+// Every pair of moves from the root, the subtrees below them are the units of work
+static std::vector<std::pair<Move, Move>> getSplitMoves(const Position &position){
+    std::vector<std::pair<Move, Move>> splitMoves;
+    Position current = position;
+    MoveList rootMoves;
+    current.generateMoves(rootMoves, GEN_ALL);
+
+    for(Move root : rootMoves) {
+        Position next = current;
+        next.applyMove(root);
+
+        MoveList replies;
+        next.generateMoves(replies, GEN_ALL);
+        for(Move reply : replies) {
+            splitMoves.push_back({root, reply});
+        }
+    }
+
+    return splitMoves;
+}
+
+// Runs count on every split position with the given number of threads, then merges the results with add.
+template<typename Result, typename Count, typename Add>
+static Result splitPerft(const Chess &chess, int depth, int threads, Count count, Add add){
+    if(threads <= 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    std::vector<std::pair<Move, Move>> splitMoves = getSplitMoves(chess);
+    std::atomic<size_t> nextMove(0);
+    std::vector<Result> results(threads, Result());
+    std::vector<std::thread> workers;
+
+    for(int i = 0; i < threads; i++) {
+        workers.emplace_back([&, i]() {
+            Chess position = chess;
+
+            for(size_t index = nextMove++; index < splitMoves.size(); index = nextMove++) {
+                position.makeMove(splitMoves[index].first);
+                position.makeMove(splitMoves[index].second);
+                add(results[i], count(position, depth - 2));
+                position.undoMove();
+                position.undoMove();
+            }
+        });
+    }
+
+    Result total = Result();
+    for(int i = 0; i < threads; i++) {
+        workers[i].join();
+        add(total, results[i]);
+    }
+
+    return total;
+}
+
+// The split moves are made on the history of the game, without room for them the tree is counted in one thread
+PerftResults perftParallel(const Chess &chess, int depth, int threads){
+    if(depth < 2 || chess.totalMoves + depth > MAX_HISTORY) {
+        Chess position = chess;
+        return position.perft(depth);
+    }
+
+    return splitPerft<PerftResults>(chess, depth, threads,
+        [](Chess &position, int subDepth) { return position.perft(subDepth); },
+        [](PerftResults &total, const PerftResults &other) { total.add(other); });
+}
+
+uint64_t perftBulkParallel(const Chess &chess, int depth, int threads){
+    if(depth < 2 || chess.totalMoves + depth > MAX_HISTORY) {
+        Chess position = chess;
+        return perftBulk(position, depth);
+    }
+
+    return splitPerft<uint64_t>(chess, depth, threads,
+        [](Chess &position, int subDepth) { return perftBulk(position, subDepth); },
+        [](uint64_t &total, uint64_t other) { total += other; });
+}
+
+bool runPerftSuite(const std::string &path, int maxDepth, int threads){
+    std::ifstream file(path);
+    if(!file.is_open()) {
+        std::cout << "Could not open " << path << std::endl;
+        return false;
+    }
+
+    int passed = 0;
+    int failed = 0;
+    uint64_t totalNodes = 0;
+    long long totalTime = 0;
+    std::string line;
+
+    while(std::getline(file, line)) {
+        size_t fenEnd = line.find(';');
+        std::string fen = line.substr(0, fenEnd);
+        size_t fenStart = fen.find_first_not_of(" \t\r");
+        if(fenStart == std::string::npos) continue;
+        fen = fen.substr(fenStart, fen.find_last_not_of(" \t\r") - fenStart + 1);
+
+        Chess chess;
+        if(!chess.loadFen(fen)) {
+            std::cout << "Invalid fen: " << fen << std::endl;
+            failed++;
+            continue;
+        }
+
+        // Each field after the fen is ";D<depth> <nodes>"
+        while(fenEnd != std::string::npos) {
+            size_t fieldEnd = line.find(';', fenEnd + 1);
+            std::istringstream field(line.substr(fenEnd + 1, fieldEnd - fenEnd - 1));
+            fenEnd = fieldEnd;
+
+            char d;
+            int depth;
+            uint64_t expected;
+            if(!(field >> d >> depth >> expected) || d != 'D' || depth > maxDepth) continue;
+
+            auto t1 = std::chrono::high_resolution_clock::now();
+            uint64_t nodes = perftBulkParallel(chess, depth, threads);
+            auto t2 = std::chrono::high_resolution_clock::now();
+            long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
+
+            bool ok = nodes == expected;
+            if(ok) passed++;
+            else failed++;
+            totalNodes += nodes;
+            totalTime += ms;
+
+            std::cout << (ok ? "pass " : "FAIL ") << fen << " depth " << depth << ": " << nodes;
+            if(!ok) std::cout << " expected " << expected;
+            std::cout << ", " << ms << "ms, " << nodes / (ms + 1) << " knps" << std::endl;
+        }
+    }
+
+    std::cout << "\n" << passed << " passed, " << failed << " failed, " << totalNodes << " nodes in " << totalTime
+        << "ms, " << totalNodes / (totalTime + 1) << " knps" << std::endl;
+
+    return failed == 0;
+}
@@ -0,0 +1,43 @@
+#ifndef __PERFT__
+#define __PERFT__
+#include <cstdint>
+#include <vector>
+#include <string>
+
+#include "chess.h"
+
+// Subtree count of a position at a given depth. The depth is kept in the low byte of data and the count in the rest.
+typedef struct PerftEntry {
+    uint64_t key = 0;
+    uint64_t data = 0;
+} PerftEntry;
+
+// Hash table for perft, positions reached by different move orders are only counted once. Entries are always
+// replaced, perft doesnt need anything smarter.
+class PerftTable{
+public:
+    std::vector<PerftEntry> entries;
+    uint64_t mask;
+
+    PerftTable(size_t sizeMB);
+    bool probe(uint64_t key, int depth, uint64_t &count);
+    void store(uint64_t key, int depth, uint64_t count);
+};
+
+// Counts the leaf nodes only, the last ply is the size of the legal move list instead of making every move.
+// The table is optional.
+uint64_t perftBulk(Chess &chess, int depth, PerftTable *table = nullptr);
+// Same count with copy-make, every ply plays the moves on a copy of the position instead of undoing them.
+uint64_t perftCopyMake(const Position &position, int depth);
+
+// Parallel versions, the tree is split two plies below the root and the threads take the subtrees from a shared
+// counter. Each thread works on its own copy of the position and the results are merged at the end.
+// With threads = 0 all the hardware threads are used.
+PerftResults perftParallel(const Chess &chess, int depth, int threads = 0);
+uint64_t perftBulkParallel(const Chess &chess, int depth, int threads = 0);
+
+// Runs every position of an EPD file with lines like "<fen> ;D1 20 ;D2 400", up to maxDepth. Prints the result and
+// speed of each position and returns true if all the counts match.
+bool runPerftSuite(const std::string &path, int maxDepth, int threads = 0);
+
+#endif // __PERFT__
@@ -0,0 +1,135 @@
+#include "piecesquare.h"
+
+// Values of the white pieces, indexed by piece type (piece / 2). Pawns are worth more once they can run, minor
+// pieces less.
+constexpr int MG_MATERIAL[7] = { 0, 100, 350, 350, 525, 1000, 0 };
+constexpr int EG_MATERIAL[7] = { 0, 120, 330, 350, 550, 1000, 0 };
+constexpr int PHASE_WEIGHTS[7] = { 0, 0, 1, 1, 2, 4, 0 };
+
+// From A1 to H8, so the first row of each table is the first rank of white
+constexpr int MG_SQUARES[7][64] = {
+    {},
+    {
+        0,  0,  0,  0,  0,  0,  0,  0,
+        5, 10, 10,-20,-20, 10, 10,  5,
+        5, -5,-10,  0,  0,-10, -5,  5,
+        0,  0,  0, 50, 50,  0,  0,  0,
+        5,  5, 10, 25, 25, 10,  5,  5,
+        10, 10, 20, 30, 30, 20, 10, 10,
+        0, 50, 50, 50, 50, 50, 50, 50,
+        0,  0,  0,  0,  0,  0,  0,  0
+    },
+    {
+        -50,-40,-30,-30,-30,-30,-40,-50,
+        -40,-20,  0,  5,  5,  0,-20,-40,
+        -30,  5, 10, 15, 15, 10,  5,-30,
+        -30,  0, 15, 20, 20, 15,  0,-30,
+        -30,  5, 15, 20, 20, 15,  5,-30,
+        -30,  0, 10, 15, 15, 10,  0,-30,
+        -40,-20,  0,  0,  0,  0,-20,-40,
+        -50,-40,-30,-30,-30,-30,-40,-50
+    },
+    {
+        -20,-10,-10,-10,-10,-10,-10,-20,
+        -10,  5,  0,  0,  0,  0,  5,-10,
+        -10, 10, 10, 10, 10, 10, 10,-10,
+        -10,  0, 10, 10, 10, 10,  0,-10,
+        -10,  5,  5, 10, 10,  5,  5,-10,
+        -10,  0,  5, 10, 10,  5,  0,-10,
+        -10,  0,  0,  0,  0,  0,  0,-10,
+        -20,-10,-10,-10,-10,-10,-10,-20
+    },
+    {
+        0,  0,  0,  5,  5,  0,  0,  0,
+        -5,  0,  0,  0,  0,  0,  0, -5,
+        -5,  0,  0,  0,  0,  0,  0, -5,
+        -5,  0,  0,  0,  0,  0,  0, -5,
+        -5,  0,  0,  0,  0,  0,  0, -5,
+        -5,  0,  0,  0,  0,  0,  0, -5,
+        5, 10, 10, 10, 10, 10, 10,  5,
+        0,  0,  0,  0,  0,  0,  0,  0
+    },
+    {
+        -20,-10,-10, -5, -5,-10,-10,-20,
+        -10,  0,  5,  0,  0,  0,  0,-10,
+        -10,  5,  5,  5,  5,  5,  0,-10,
+        0,  0,  5,  5,  5,  5,  0, -5,
+        -5,  0,  5,  5,  5,  5,  0, -5,
+        -10,  0,  5,  5,  5,  5,  0,-10,
+        -10,  0,  0,  0,  0,  0,  0,-10,
+        -20,-10,-10, -5, -5,-10,-10,-20
+    },
+    {
+        20, 30, 10,  0,  0, 10, 30, 20,
+        20, 20,  0,  0,  0,  0, 20, 20,
+        10,-20,-20,-20,-20,-20,-20,-10,
+        -20,-30,-30,-40,-40,-30,-30,-20,
+        -30,-40,-40,-50,-50,-40,-40,-30,
+        -30,-40,-40,-50,-50,-40,-40,-30,
+        -30,-40,-40,-50,-50,-40,-40,-30,
+        -30,-40,-40,-50,-50,-40,-40,-30
+    }
+};
+
+// In the endgame pawns gain as they get closer to promoting and the king comes to the center, the other pieces keep
+// their middlegame squares
+constexpr int EG_PAWN_SQUARES[64] = {
+    0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,
+    5,  5,  5,  5,  5,  5,  5,  5,
+    10, 10, 10, 10, 10, 10, 10, 10,
+    20, 20, 20, 20, 20, 20, 20, 20,
+    35, 35, 35, 35, 35, 35, 35, 35,
+    60, 60, 60, 60, 60, 60, 60, 60,
+    0,  0,  0,  0,  0,  0,  0,  0
+};
+constexpr int EG_KING_SQUARES[64] = {
+    -50,-30,-30,-30,-30,-30,-30,-50,
+    -30,-30,  0,  0,  0,  0,-30,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-20,-10,  0,  0,-10,-20,-30,
+    -50,-40,-30,-20,-20,-30,-40,-50
+};
+
+constexpr int egSquare(int type, int sq){
+    if(type == 1) return EG_PAWN_SQUARES[sq];
+    if(type == 6) return EG_KING_SQUARES[sq];
+    return MG_SQUARES[type][sq];
+}
+
+constexpr std::array<Score, 14> genMaterial(){
+    std::array<Score, 14> material = {};
+    for(int piece = W_PAWN; piece <= B_KING; piece++){
+        Score score = makeScore(MG_MATERIAL[piece / 2], EG_MATERIAL[piece / 2]);
+        material[piece] = piece % 2 == WHITE ? score : -score;
+    }
+    return material;
+}
+
+constexpr std::array<std::array<Score, 64>, 14> genSquares(){
+    std::array<std::array<Score, 64>, 14> squares = {};
+    for(int piece = W_PAWN; piece <= B_KING; piece++){
+        int type = piece / 2;
+        for(int sq = 0; sq < 64; sq++){
+            int whiteSq = piece % 2 == WHITE ? sq : 63 - sq;
+            Score score = makeScore(MG_SQUARES[type][whiteSq], egSquare(type, whiteSq));
+            squares[piece][sq] = piece % 2 == WHITE ? score : -score;
+        }
+    }
+    return squares;
+}
+
+constexpr std::array<int, 14> genPhase(){
+    std::array<int, 14> phase = {};
+    for(int piece = W_PAWN; piece <= B_KING; piece++){
+        phase[piece] = PHASE_WEIGHTS[piece / 2];
+    }
+    return phase;
+}
+
+const std::array<Score, 14> PieceSquare::material = genMaterial();
+const std::array<std::array<Score, 64>, 14> PieceSquare::squares = genSquares();
+const std::array<int, 14> PieceSquare::phase = genPhase();
@@ -0,0 +1,32 @@
+#ifndef __PIECESQUARE__
+#define __PIECESQUARE__
+#include <cstdint>
+#include <array>
+
+#include "move_structs.h"
+
+// Middlegame and endgame values in centipawns packed in one integer, the endgame in the upper 16 bits. Adding or
+// subtracting two scores adds both halves at once, the carry of a negative middlegame is undone when unpacking.
+typedef int32_t Score;
+
+constexpr Score makeScore(int mg, int eg){ return (Score)((uint32_t)eg << 16) + mg; }
+constexpr int mgValue(Score score){ return (int16_t)(uint16_t)(uint32_t)score; }
+constexpr int egValue(Score score){ return (int16_t)(uint16_t)((uint32_t)(score + 0x8000) >> 16); }
+
+// Phase of a position with every piece on the board, it goes down to 0 as pieces are traded
+const int MAX_PHASE = 24;
+
+// Material and piece-square scores from the white side, so black pieces have negative values. The position keeps
+// the sum of both for its pieces, updated with the pieces that move, so the evaluation doesnt have to go over the
+// boards. Black squares are the white ones turned around.
+class PieceSquare{
+public:
+    // Indexed by piece, the color entries are 0
+    static const std::array<Score, 14> material;
+    // Indexed by piece and square
+    static const std::array<std::array<Score, 64>, 14> squares;
+    // Weight of each piece in the game phase, by piece
+    static const std::array<int, 14> phase;
+};
+
+#endif // __PIECESQUARE__
@@ -0,0 +1,526 @@
+#include "position.h"
+#include <iostream>
+#include <algorithm>
+#include <utility>
+
+const Generator Position::generator;
+
+// Returns the origin of the attackers to a square.
+uint64_t Position::attacksToSquare(Square sq, Piece color){
+    return attacksToSquare(sq, color, occupiedBoard);
+}
+
+// Same but with a custom occupied board for the sliders, so the king can be removed when looking for safe squares.
+uint64_t Position::attacksToSquare(Square sq, Piece color, uint64_t occupied){
+    Piece attColor = (color == WHITE) ? BLACK : WHITE;
+
+    uint64_t diagonals = currentBoard[attColor + W_BISHOP] | currentBoard[attColor + W_QUEEN];
+    uint64_t lines = currentBoard[attColor + W_ROOK] | currentBoard[attColor + W_QUEEN];
+
+    uint64_t pawnAttack = generator.pawnAttacks[color][sq] & currentBoard[attColor + W_PAWN];
+    uint64_t kightAttack = generator.knightMoves[sq] & currentBoard[attColor + W_KNIGHT];
+    uint64_t bishopAttack = generator.getBishopMoveboard(sq, occupied) & diagonals;
+    uint64_t rookAttack = generator.getRookMoveboard(sq, occupied) & lines;
+    uint64_t kingAttack = generator.kingMoves[sq] & currentBoard[attColor + W_KING];
+
+    uint64_t attacks = pawnAttack | kightAttack | bishopAttack | rookAttack | kingAttack;
+
+    return attacks;
+}
+
+bool Position::isInCheck(){
+    Square kingSquare = (Square)__builtin_ctzll(currentBoard[colorTurn + W_KING]);
+    return attacksToSquare(kingSquare, colorTurn) != 0;
+}
+
+// Static exchange evaluation, the material won by the side to move if both sides keep capturing on the target
+// square with their least valuable piece, and can stop when going on would lose more. Pieces removed from the
+// occupied board uncover the sliders behind them. Pins are ignored.
+int Position::see(Move move){
+    uint8_t flags = move.getFlags();
+    if(flags == KING_CASTLE || flags == QUEEN_CASTLE) {
+        return 0;
+    }
+
+    Square from = (Square)move.getFrom();
+    Square to = (Square)move.getTo();
+    uint64_t occupied = occupiedBoard ^ (1ULL << from);
+
+    // Gain of each capture of the sequence, for the side that makes it
+    int gain[32];
+    int count = 0;
+    int attackerValue = PIECE_VALUES[pieceAt[from] / 2];
+
+    if(flags == EP_CAPTURE) {
+        gain[0] = PIECE_VALUES[1];
+        occupied ^= 1ULL << (colorTurn == WHITE ? to - 8 : to + 8);
+    }
+    else {
+        gain[0] = flags == CAPTURE_MOVE || flags >= KNIGHT_PROMOTION_C ? PIECE_VALUES[pieceAt[to] / 2] : 0;
+    }
+    if(flags >= KNIGHT_PROMOTION) {
+        attackerValue = PIECE_VALUES[flagToPiece[flags - FLAG_OFFSET] / 2];
+        gain[0] += attackerValue - PIECE_VALUES[1];
+    }
+
+    uint64_t diagonals = currentBoard[W_BISHOP] | currentBoard[B_BISHOP] | currentBoard[W_QUEEN] | currentBoard[B_QUEEN];
+    uint64_t lines = currentBoard[W_ROOK] | currentBoard[B_ROOK] | currentBoard[W_QUEEN] | currentBoard[B_QUEEN];
+    uint64_t attackers = (attacksToSquare(to, WHITE, occupied) | attacksToSquare(to, BLACK, occupied)) & occupied;
+    Piece side = oppColor;
+
+    while(count < 31) {
+        uint64_t sideAttackers = attackers & currentBoard[side];
+        if(sideAttackers == 0) break;
+
+        int type = 1;
+        uint64_t pieces = 0;
+        for(; type <= 6; type++) {
+            pieces = sideAttackers & currentBoard[type * 2 + side];
+            if(pieces) break;
+        }
+
+        // The king can only take last, if nothing defends the square anymore
+        if(type == 6 && (attackers & currentBoard[side ^ 1])) break;
+
+        count++;
+        gain[count] = attackerValue - gain[count - 1];
+        attackerValue = PIECE_VALUES[type];
+
+        occupied ^= pieces & (~pieces + 1);
+        if(type == 1 || type == 3 || type == 5) attackers |= generator.getBishopMoveboard(to, occupied) & diagonals;
+        if(type == 4 || type == 5) attackers |= generator.getRookMoveboard(to, occupied) & lines;
+        attackers &= occupied;
+        side = (Piece)(side ^ 1);
+    }
+
+    // Each side stops the sequence when capturing would lose material
+    while(count > 0) {
+        gain[count - 1] = -std::max(-gain[count - 1], gain[count]);
+        count--;
+    }
+
+    return gain[0];
+}
+
+uint64_t Position::computePawnKey(){
+    uint64_t pawnKey = 0;
+
+    for(int piece = W_PAWN; piece <= B_PAWN; piece++){
+        uint64_t pawns = currentBoard[piece];
+        while(pawns){
+            int sq = __builtin_ctzll(pawns);
+            pawns &= pawns - 1;
+            pawnKey ^= Zobrist::pieceKeys[piece][sq];
+        }
+    }
+
+    return pawnKey;
+}
+
+// Material, square scores and phase, computed from scratch.
+void Position::computeScores(){
+    material = 0;
+    pstScore = 0;
+    phase = 0;
+
+    for(int piece = W_PAWN; piece <= B_KING; piece++){
+        uint64_t pieces = currentBoard[piece];
+        while(pieces){
+            int sq = __builtin_ctzll(pieces);
+            pieces &= pieces - 1;
+            addPieceScore((Piece)piece, sq);
+        }
+    }
+}
+
+// Zobrist hash of the position, computed from scratch.
+uint64_t Position::computeKey(){
+    uint64_t key = 0;
+
+    for(int piece = W_PAWN; piece <= B_KING; piece++){
+        uint64_t pieces = currentBoard[piece];
+        while(pieces){
+            int sq = __builtin_ctzll(pieces);
+            pieces &= pieces - 1;
+            key ^= Zobrist::pieceKeys[piece][sq];
+        }
+    }
+
+    key ^= Zobrist::castleKeys[Zobrist::castleIndex(gameState)];
+
+    if(enpassantSquare > 0) {
+        key ^= Zobrist::enpassantKeys[enpassantSquare % 8];
+    }
+
+    if(colorTurn == BLACK) {
+        key ^= Zobrist::sideKey;
+    }
+
+    return key;
+}
+
+// Castling rights lost when the rook on this square moves or is captured
+inline uint8_t rookCastleRights(uint8_t sq){
+    switch(sq){
+        case A1: return CASTLE_A1;
+        case H1: return CASTLE_H1;
+        case A8: return CASTLE_A8;
+        case H8: return CASTLE_H8;
+        default: return 0;
+    }
+}
+
+// Moves a piece without saving any history, returns the captured piece. Specialized for the side that moves, so
+// all the per color squares and offsets are constants.
+template<Piece Us>
+Piece Position::applyMoveFor(Move pieceMove){
+    constexpr Piece Them = Us == WHITE ? BLACK : WHITE;
+    constexpr int forward = Us == WHITE ? 8 : -8;
+    constexpr uint8_t kingCastleRights = Us == WHITE ? (CASTLE_A1 | CASTLE_H1) : (CASTLE_A8 | CASTLE_H8);
+    constexpr uint64_t kingRookMove = Us == WHITE ? (1ULL << H1) | (1ULL << F1) : (1ULL << H8) | (1ULL << F8);
+    constexpr uint64_t queenRookMove = Us == WHITE ? (1ULL << A1) | (1ULL << D1) : (1ULL << A8) | (1ULL << D8);
+
+    uint8_t from = pieceMove.getFrom();
+    uint8_t to = pieceMove.getTo();
+    uint8_t flags = pieceMove.getFlags();
+    Piece pieceType = pieceAt[from];
+    Piece captured = pieceAt[to];
+
+    // The old castling rights and en passant file are removed from the key, the new ones are added at the end
+    key ^= Zobrist::castleKeys[Zobrist::castleIndex(gameState)];
+    if(enpassantSquare > 0) {
+        key ^= Zobrist::enpassantKeys[enpassantSquare % 8];
+    }
+    enpassantSquare = A1;
+
+    // Update piece and color bitboards
+    uint64_t fromBB = (1ULL << from);
+    uint64_t toBB = (1ULL << to);
+    uint64_t fromToBB =  fromBB ^ toBB;
+    currentBoard[Us] ^= fromToBB;
+    currentBoard[pieceType] ^= fromToBB;
+    pieceAt[from] = UNKNOWN;
+    pieceAt[to] = pieceType;
+    key ^= Zobrist::pieceKeys[pieceType][from] ^ Zobrist::pieceKeys[pieceType][to];
+    if(pieceType == (Us + W_PAWN)) pawnKey ^= Zobrist::pieceKeys[pieceType][from] ^ Zobrist::pieceKeys[pieceType][to];
+    pstScore += PieceSquare::squares[pieceType][to] - PieceSquare::squares[pieceType][from];
+
+    // The fifty moves counter restarts with pawn moves and captures, en passant is a pawn move anyway
+    if(pieceType == (Us + W_PAWN) || captured != UNKNOWN) halfMoves = 0;
+    else halfMoves++;
+
+    // Check if a rook move to disable castling
+    if(pieceType == (Us + W_ROOK)){
+        gameState &= ~rookCastleRights(from);
+    }
+    else if(pieceType == (Us + W_KING)){
+        gameState &= ~kingCastleRights;
+    }
+
+    switch(flags) {
+        case KING_CASTLE: {
+            currentBoard[Us] ^= kingRookMove;
+            currentBoard[Us + W_ROOK] ^= kingRookMove;
+            pieceAt[Us == WHITE ? H1 : H8] = UNKNOWN;
+            pieceAt[Us == WHITE ? F1 : F8] = (Piece)(Us + W_ROOK);
+            key ^= Zobrist::pieceKeys[Us + W_ROOK][Us == WHITE ? H1 : H8] ^ Zobrist::pieceKeys[Us + W_ROOK][Us == WHITE ? F1 : F8];
+            removePieceScore((Piece)(Us + W_ROOK), Us == WHITE ? H1 : H8);
+            addPieceScore((Piece)(Us + W_ROOK), Us == WHITE ? F1 : F8);
+            break;
+        }
+        case QUEEN_CASTLE: {
+            currentBoard[Us] ^= queenRookMove;
+            currentBoard[Us + W_ROOK] ^= queenRookMove;
+            pieceAt[Us == WHITE ? A1 : A8] = UNKNOWN;
+            pieceAt[Us == WHITE ? D1 : D8] = (Piece)(Us + W_ROOK);
+            key ^= Zobrist::pieceKeys[Us + W_ROOK][Us == WHITE ? A1 : A8] ^ Zobrist::pieceKeys[Us + W_ROOK][Us == WHITE ? D1 : D8];
+            removePieceScore((Piece)(Us + W_ROOK), Us == WHITE ? A1 : A8);
+            addPieceScore((Piece)(Us + W_ROOK), Us == WHITE ? D1 : D8);
+            break;
+        }
+        case CAPTURE_MOVE: {
+            currentBoard[Them] ^= toBB;
+            currentBoard[captured] ^= toBB;
+            key ^= Zobrist::pieceKeys[captured][to];
+            if(captured == (Them + W_PAWN)) pawnKey ^= Zobrist::pieceKeys[captured][to];
+            removePieceScore(captured, to);
+
+            if(captured == (Them + W_ROOK)) {
+                gameState &= ~rookCastleRights(to);
+            }
+            break;
+        }
+        case KNIGHT_PROMOTION: case BISHOP_PROMOTION: case ROOK_PROMOTION: case QUEEN_PROMOTION: {
+            Piece promotionPiece = (Piece)(Us + flagToPiece[flags - FLAG_OFFSET]);
+            currentBoard[pieceType] ^= toBB; // Remove pawn
+            currentBoard[promotionPiece] ^= toBB; // Add piece promoted
+            pieceAt[to] = promotionPiece; // At piece type for faster lookup
+            key ^= Zobrist::pieceKeys[pieceType][to] ^ Zobrist::pieceKeys[promotionPiece][to];
+            pawnKey ^= Zobrist::pieceKeys[pieceType][to];
+            removePieceScore(pieceType, to);
+            addPieceScore(promotionPiece, to);
+            break;
+        }
+        case KNIGHT_PROMOTION_C: case BISHOP_PROMOTION_C: case ROOK_PROMOTION_C: case QUEEN_PROMOTION_C: {
+            Piece promotionPiece = (Piece)(Us + flagToPiece[flags - FLAG_OFFSET]);
+            currentBoard[pieceType] ^= toBB;
+            currentBoard[promotionPiece] ^= toBB;
+            pieceAt[to] = promotionPiece;
+            
+            currentBoard[Them] ^= toBB;
+            currentBoard[captured] ^= toBB;
+            key ^= Zobrist::pieceKeys[pieceType][to] ^ Zobrist::pieceKeys[promotionPiece][to] ^ Zobrist::pieceKeys[captured][to];
+            pawnKey ^= Zobrist::pieceKeys[pieceType][to];
+            removePieceScore(pieceType, to);
+            addPieceScore(promotionPiece, to);
+            removePieceScore(captured, to);
+
+            // If we captured a rook we disable castling rights
+            if(captured == (Them + W_ROOK)) {
+                gameState &= ~rookCastleRights(to);
+            }
+            break;
+        }
+        case DOUBLE_PAWN: {
+            enpassantSquare = (Square)(from + forward);
+            key ^= Zobrist::enpassantKeys[enpassantSquare % 8];
+            break;
+        }
+        case EP_CAPTURE: {
+            // Offset to get en passant captured pawn
+            to = (Square)(to - forward);
+            toBB = (1ULL << to);
+            captured = pieceAt[to];
+            pieceAt[to] = UNKNOWN;
+            currentBoard[Them] ^= toBB;
+            currentBoard[captured] ^= toBB;
+            key ^= Zobrist::pieceKeys[captured][to];
+            pawnKey ^= Zobrist::pieceKeys[captured][to];
+            removePieceScore(captured, to);
+            break;
+        }
+        default: break;
+    }
+
+    key ^= Zobrist::castleKeys[Zobrist::castleIndex(gameState)] ^ Zobrist::sideKey;
+    colorTurn = Them;
+    oppColor = Us;
+
+    occupiedBoard = currentBoard[WHITE] | currentBoard[BLACK];
+
+    return captured;
+}
+
+Piece Position::applyMove(Move pieceMove){
+    Piece captured = colorTurn == WHITE ? applyMoveFor<WHITE>(pieceMove) : applyMoveFor<BLACK>(pieceMove);
+    #ifdef ZOBRIST_DEBUG
+    verifyKey(pieceMove);
+    #endif
+    return captured;
+}
+
+// Passes the turn, only used by the search. The move counter is reset so repetitions are not looked for across it.
+void Position::applyNullMove(){
+    if(enpassantSquare > 0) {
+        key ^= Zobrist::enpassantKeys[enpassantSquare % 8];
+    }
+    enpassantSquare = A1;
+    key ^= Zobrist::sideKey;
+
+    std::swap(colorTurn, oppColor);
+    halfMoves = 0;
+}
+
+bool Position::verifyKey(Move lastMove){
+    uint64_t fullKey = computeKey();
+    uint64_t fullPawnKey = computePawnKey();
+    if(key != fullKey || pawnKey != fullPawnKey) {
+        std::cout << "Zobrist key mismatch after " << squareToString((Square)lastMove.getFrom())
+            << squareToString((Square)lastMove.getTo()) << ": incremental " << key << " pawns " << pawnKey
+            << ", recomputed " << fullKey << " pawns " << fullPawnKey << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Generates only legal moves of the given type. Checkers and pinned pieces are computed once, then every piece is
+// restricted to the squares that keep the king safe, so no move has to be made and undone.
+template<Piece Us>
+void Position::generateMovesFor(MoveList &moveList, GenType type){
+    constexpr Piece Them = Us == WHITE ? BLACK : WHITE;
+    constexpr int forward = Us == WHITE ? 8 : -8;
+    constexpr uint64_t promotionRow = Us == WHITE ? LAST_ROW : FIRST_ROW;
+
+    bool genCaptures = type != GEN_QUIETS;
+    bool genQuiets = type != GEN_CAPTURES;
+
+    uint64_t playerBoard = currentBoard[Us];
+    uint64_t oppBoard = currentBoard[Them];
+    uint64_t oppDiagonals = currentBoard[Them + W_BISHOP] | currentBoard[Them + W_QUEEN];
+    uint64_t oppLines = currentBoard[Them + W_ROOK] | currentBoard[Them + W_QUEEN];
+
+    Square kingSquare = (Square)__builtin_ctzll(currentBoard[Us + W_KING]);
+    uint64_t checkers = attacksToSquare(kingSquare, Us);
+
+    // The king is removed from the occupied board, otherwise it would hide from a slider behind itself
+    uint64_t kingOccupied = occupiedBoard ^ currentBoard[Us + W_KING];
+    uint64_t kingMoves = generator.kingMoves[kingSquare] & ~playerBoard;
+    uint64_t kingSafe = 0;
+    while(kingMoves){
+        Square to = (Square)__builtin_ctzll(kingMoves);
+        kingMoves &= kingMoves - 1;
+
+        if(attacksToSquare(to, Us, kingOccupied) == 0) {
+            kingSafe |= 1ULL << to;
+        }
+    }
+    if(genQuiets) getMovesFromBB(moveList, kingSafe & ~oppBoard, kingSquare, QUIET_MOVE);
+    if(genCaptures) getMovesFromBB(moveList, kingSafe & oppBoard, kingSquare, CAPTURE_MOVE);
+
+    // In double check only the king can move
+    if(checkers & (checkers - 1)) {
+        return;
+    }
+
+    // Other pieces must capture the checker or block it
+    uint64_t checkMask = ~0ULL;
+    if(checkers) {
+        checkMask = checkers | generator.betweenBoards[kingSquare][__builtin_ctzll(checkers)];
+    }
+
+    // The xrays from the king stop at the second blocker, so an enemy slider found there pins the first blocker
+    // if it is one of our pieces.
+    uint64_t pinned = 0;
+    uint64_t pinners = (generator.getRookXrays(kingSquare, occupiedBoard) & oppLines) |
+                        (generator.getBishopXrays(kingSquare, occupiedBoard) & oppDiagonals);
+    while(pinners){
+        int sq = __builtin_ctzll(pinners);
+        pinners &= pinners - 1;
+
+        pinned |= generator.betweenBoards[kingSquare][sq] & playerBoard;
+    }
+
+    // Pinned pieces can only move along the line between the king and the pinner
+    auto getLegalMask = [&](int sq) {
+        return (pinned & (1ULL << sq)) ? checkMask & generator.lineBoards[kingSquare][sq] : checkMask;
+    };
+    auto addPieceMoves = [&](int sq, uint64_t moveboard) {
+        moveboard &= getLegalMask(sq);
+        if(genQuiets) getMovesFromBB(moveList, moveboard & ~occupiedBoard, (Square)sq, QUIET_MOVE);
+        if(genCaptures) getMovesFromBB(moveList, moveboard & oppBoard, (Square)sq, CAPTURE_MOVE);
+    };
+
+    uint64_t pawns = currentBoard[Us + W_PAWN];
+    while(pawns){
+        int sq = __builtin_ctzll(pawns);
+        pawns &= pawns - 1;
+
+        uint64_t legalMask = getLegalMask(sq);
+        uint64_t moves = generator.pawnMoves[Us][sq] & ~occupiedBoard & legalMask;
+        uint64_t captures = generator.pawnAttacks[Us][sq] & oppBoard & legalMask;
+
+        uint64_t doublePawns = generator.doublePawns[Us][sq];
+        if(genQuiets && doublePawns && (doublePawns & occupiedBoard) == 0) {
+            Square doublePawn = (Square)(sq + 2 * forward);
+            if(legalMask & (1ULL << doublePawn)) {
+                moveList.add(Move((Square)sq, doublePawn, DOUBLE_PAWN));
+            }
+        }
+
+        // En passant removes two pieces from the same row, so it is checked by looking for sliders
+        // attacking the king after the capture. The captured pawn can be the checker.
+        if(genCaptures && enpassantSquare > 0 && (generator.pawnAttacks[Us][sq] & (1ULL << enpassantSquare))) {
+            uint64_t capturedBB = 1ULL << (enpassantSquare - forward);
+            uint64_t epOccupied = (occupiedBoard ^ (1ULL << sq) ^ capturedBB) | (1ULL << enpassantSquare);
+
+            bool resolvesCheck = (checkMask & ((1ULL << enpassantSquare) | capturedBB)) != 0;
+            bool discovered = (generator.getRookMoveboard(kingSquare, epOccupied) & oppLines) ||
+                                (generator.getBishopMoveboard(kingSquare, epOccupied) & oppDiagonals);
+
+            if(resolvesCheck && !discovered) {
+                moveList.add(Move((Square)sq, enpassantSquare, EP_CAPTURE));
+            }
+        }
+
+        // Promotions go with the captures, they change the material like a capture does
+        if(genCaptures) {
+            getMovesFromBB(moveList, moves & promotionRow, (Square)sq, KNIGHT_PROMOTION);
+            getMovesFromBB(moveList, captures & promotionRow, (Square)sq, KNIGHT_PROMOTION_C);
+            getMovesFromBB(moveList, captures & ~promotionRow, (Square)sq, CAPTURE_MOVE);
+        }
+        if(genQuiets) getMovesFromBB(moveList, moves & ~promotionRow, (Square)sq, QUIET_MOVE);
+    }
+
+    // A pinned knight can never stay on the pin line
+    uint64_t knights = currentBoard[Us + W_KNIGHT] & ~pinned;
+    while(knights){
+        int sq = __builtin_ctzll(knights);
+        knights &= knights - 1;
+        addPieceMoves(sq, generator.knightMoves[sq]);
+    }
+
+    // Queens are added once as a bishop and once as a rook
+    uint64_t diagonals = currentBoard[Us + W_BISHOP] | currentBoard[Us + W_QUEEN];
+    while(diagonals){
+        int sq = __builtin_ctzll(diagonals);
+        diagonals &= diagonals - 1;
+        addPieceMoves(sq, generator.getBishopMoveboard(sq, occupiedBoard));
+    }
+
+    uint64_t lines = currentBoard[Us + W_ROOK] | currentBoard[Us + W_QUEEN];
+    while(lines){
+        int sq = __builtin_ctzll(lines);
+        lines &= lines - 1;
+        addPieceMoves(sq, generator.getRookMoveboard(sq, occupiedBoard));
+    }
+
+    // Castling rights guarantee the king and rook are in place, the path must be empty and not attacked
+    if(genQuiets && checkers == 0) {
+        constexpr uint8_t queenCastle = Us == WHITE ? CASTLE_A1 : CASTLE_A8;
+        constexpr uint8_t kingCastle = Us == WHITE ? CASTLE_H1 : CASTLE_H8;
+        constexpr uint64_t queenPath = Us == WHITE ? 14ULL : 1008806316530991104ULL;
+        constexpr uint64_t kingPath = Us == WHITE ? 96ULL : 6917529027641081856ULL;
+        constexpr Square kingFrom = Us == WHITE ? E1 : E8;
+
+        if((gameState & queenCastle) && (occupiedBoard & queenPath) == 0 &&
+            attacksToSquare((Square)(kingFrom - 1), Us) == 0 && attacksToSquare((Square)(kingFrom - 2), Us) == 0) {
+            moveList.add(Move(kingFrom, (Square)(kingFrom - 2), QUEEN_CASTLE));
+        }
+        if((gameState & kingCastle) && (occupiedBoard & kingPath) == 0 &&
+            attacksToSquare((Square)(kingFrom + 1), Us) == 0 && attacksToSquare((Square)(kingFrom + 2), Us) == 0) {
+            moveList.add(Move(kingFrom, (Square)(kingFrom + 2), KING_CASTLE));
+        }
+    }
+}
+
+void Position::generateMoves(MoveList &moveList, GenType type){
+    if(colorTurn == WHITE) generateMovesFor<WHITE>(moveList, type);
+    else generateMovesFor<BLACK>(moveList, type);
+}
+
+MoveList Position::getLegalMoves(){
+    MoveList moveList;
+    generateMoves(moveList, GEN_ALL);
+
+    if(moveList.count == 0){
+        gameState |= GAME_OVER;
+    }
+
+    return moveList;
+}
+
+// Captures, en passant and all promotions
+void Position::getCaptureMoves(MoveList &moveList){
+    generateMoves(moveList, GEN_CAPTURES);
+}
+
+// Everything else, including castling and double pawn moves
+void Position::getQuietMoves(MoveList &moveList){
+    generateMoves(moveList, GEN_QUIETS);
+}
+
+// Moves that get the king out of check. All of them are generated at once, the check mask already limits the
+// pieces to the few squares that matter.
+void Position::getEvasionMoves(MoveList &moveList){
+    generateMoves(moveList, GEN_EVASIONS);
+}
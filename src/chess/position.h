@@ -0,0 +1,135 @@
+#ifndef __POSITION__
+#define __POSITION__
+
+#include <cstdint>
+#include <type_traits>
+
+#include "generator.h"
+#include "zobrist.h"
+#include "piecesquare.h"
+#include "move_structs.h"
+
+// Kinds of moves the legal generator can produce. Captures include promotions and en passant.
+enum GenType : uint8_t {
+    GEN_ALL,
+    GEN_CAPTURES,
+    GEN_QUIETS,
+    GEN_EVASIONS
+};
+
+// Values of the pieces in centipawns for exchanges, indexed by piece type (piece / 2). Also used to order captures.
+const int PIECE_VALUES[7] = { 0, 100, 320, 330, 500, 900, 20000 };
+
+// The board state needed to generate and play moves, without any history. It is trivially copyable and small, so
+// the search can keep a copy per ply instead of undoing moves, and threads can copy it freely.
+typedef struct Position {
+    // Lookup tables are shared by every position
+    static const Generator generator;
+
+    // Array representing the current state of the board, one bitboard for each color and piece
+    uint64_t currentBoard[14];
+    uint64_t occupiedBoard;
+    // For faster lookup while move generating
+    Piece pieceAt[64];
+
+    // Tell us about castling rights and if the game is over
+    uint8_t gameState;
+    Piece colorTurn;
+    Piece oppColor;
+    // Square behind a pawn that just moved two squares, A1 if there is none
+    Square enpassantSquare;
+    // Moves since capture or pawn move
+    int halfMoves;
+    // Zobrist key, updated by applyMove. Building with ZOBRIST_DEBUG checks it against computeKey after every move.
+    uint64_t key;
+    // Same keys for the pawns only, the pawn structure is evaluated once per key
+    uint64_t pawnKey;
+    // Sums of PieceSquare for the pieces on the board, updated by applyMove like the key
+    Score material;
+    Score pstScore;
+    int phase;
+
+    Piece applyMove(Move pieceMove);
+    template<Piece Us> Piece applyMoveFor(Move pieceMove);
+    void applyNullMove();
+    uint64_t attacksToSquare(Square sq, Piece color);
+    uint64_t attacksToSquare(Square sq, Piece color, uint64_t occupied);
+    bool isInCheck();
+    uint64_t computeKey();
+    uint64_t computePawnKey();
+    void computeScores();
+    bool verifyKey(Move lastMove);
+    int see(Move move);
+    void generateMoves(MoveList &moveList, GenType type);
+    template<Piece Us> void generateMovesFor(MoveList &moveList, GenType type);
+    MoveList getLegalMoves();
+    void getCaptureMoves(MoveList &moveList);
+    void getQuietMoves(MoveList &moveList);
+    void getEvasionMoves(MoveList &moveList);
+
+    void addPieceScore(Piece piece, int sq){
+        material += PieceSquare::material[piece];
+        pstScore += PieceSquare::squares[piece][sq];
+        phase += PieceSquare::phase[piece];
+    }
+
+    void removePieceScore(Piece piece, int sq){
+        material -= PieceSquare::material[piece];
+        pstScore -= PieceSquare::squares[piece][sq];
+        phase -= PieceSquare::phase[piece];
+    }
+
+    // Generates a list of moves for a given piece moveboard.
+    void getMovesFromBB(MoveList &moveList, uint64_t bitboard, Square squareFrom, uint8_t flag){
+        switch(flag) {
+            case KNIGHT_PROMOTION: {
+                while(bitboard > 0){
+                    Square squareTo = (Square)__builtin_ctzll(bitboard);
+                    bitboard &= bitboard - 1;
+        
+                    Move knightPromotion(squareFrom, squareTo, KNIGHT_PROMOTION);
+                    Move bishopPromotion(squareFrom, squareTo, BISHOP_PROMOTION);
+                    Move rookPromotion(squareFrom, squareTo, ROOK_PROMOTION);
+                    Move queenPromotion(squareFrom, squareTo, QUEEN_PROMOTION);
+                    moveList.add(knightPromotion);
+                    moveList.add(bishopPromotion);
+                    moveList.add(rookPromotion);
+                    moveList.add(queenPromotion);
+                }
+                break;
+            }
+            case KNIGHT_PROMOTION_C: {
+                while(bitboard > 0){
+                    Square squareTo = (Square)__builtin_ctzll(bitboard);
+                    bitboard &= bitboard - 1;
+        
+                    Move knightPromotion(squareFrom, squareTo, KNIGHT_PROMOTION_C);
+                    Move bishopPromotion(squareFrom, squareTo, BISHOP_PROMOTION_C);
+                    Move rookPromotion(squareFrom, squareTo, ROOK_PROMOTION_C);
+                    Move queenPromotion(squareFrom, squareTo, QUEEN_PROMOTION_C);
+                    moveList.add(knightPromotion);
+                    moveList.add(bishopPromotion);
+                    moveList.add(rookPromotion);
+                    moveList.add(queenPromotion);
+                }
+                break;
+            }
+            case QUIET_MOVE: case CAPTURE_MOVE: case DOUBLE_PAWN: {
+                while(bitboard > 0){
+                    Square squareTo = (Square)__builtin_ctzll(bitboard);
+                    bitboard &= bitboard - 1;
+        
+                    Move newMove(squareFrom, squareTo, flag);
+                    moveList.add(newMove);
+                }
+                break;
+            }
+            default: break;
+        }
+    }
+} Position;
+
+static_assert(std::is_trivially_copyable<Position>::value && std::is_standard_layout<Position>::value,
+    "Position must stay trivially copyable, the search copies it for every ply");
+
+#endif // __POSITION__
@@ -0,0 +1,47 @@
+#include "zobrist.h"
+
+// Xorshift64* generator, only used at compile time
+constexpr uint64_t nextRandom(uint64_t &state){
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+struct ZobristKeys {
+    std::array<SquareBoards, 14> pieces = {};
+    std::array<uint64_t, 16> castles = {};
+    std::array<uint64_t, 8> enpassant = {};
+    uint64_t side = 0;
+};
+
+constexpr ZobristKeys genZobristKeys(){
+    ZobristKeys keys;
+    uint64_t state = 1070372ULL;
+
+    for(int piece = W_PAWN; piece <= B_KING; piece++){
+        for(int sq = 0; sq < 64; sq++){
+            keys.pieces[piece][sq] = nextRandom(state);
+        }
+    }
+
+    // No castling rights hash to zero, so a position without them only depends on the pieces
+    for(int i = 1; i < 16; i++){
+        keys.castles[i] = nextRandom(state);
+    }
+
+    for(int i = 0; i < 8; i++){
+        keys.enpassant[i] = nextRandom(state);
+    }
+
+    keys.side = nextRandom(state);
+
+    return keys;
+}
+
+constexpr ZobristKeys ZOBRIST_KEYS = genZobristKeys();
+
+const std::array<SquareBoards, 14> Zobrist::pieceKeys = ZOBRIST_KEYS.pieces;
+const std::array<uint64_t, 16> Zobrist::castleKeys = ZOBRIST_KEYS.castles;
+const std::array<uint64_t, 8> Zobrist::enpassantKeys = ZOBRIST_KEYS.enpassant;
+const uint64_t Zobrist::sideKey = ZOBRIST_KEYS.side;
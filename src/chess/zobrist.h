@@ -0,0 +1,26 @@
+#ifndef __ZOBRIST__
+#define __ZOBRIST__
+#include <cstdint>
+#include <array>
+
+#include "generator.h"
+#include "move_structs.h"
+
+// Random keys used to hash a position. A key is the xor of the keys of every piece on its square, the castling
+// rights, the en passant file and the side to move. The keys are generated at compile time with a fixed seed, so
+// hashes are the same on every run and platform.
+class Zobrist{
+public:
+    // Indexed by piece and square, the color entries are not used
+    static const std::array<SquareBoards, 14> pieceKeys;
+    // Indexed by the castling bits of the game state
+    static const std::array<uint64_t, 16> castleKeys;
+    // Indexed by the file of the en passant square
+    static const std::array<uint64_t, 8> enpassantKeys;
+    // Used when black is to move
+    static const uint64_t sideKey;
+
+    static constexpr int castleIndex(uint8_t gameState){ return (gameState >> 1) & 15; }
+};
+
+#endif // __ZOBRIST__
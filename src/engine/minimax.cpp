@@ -1,336 +1,658 @@
 #include "minimax.h"
 #include <chrono>
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+
+#include "numa.h"
+
+// The table keeps mates as plies from the stored node instead of from the root, so they stay right when the
+// position is reached at another ply
+static inline int scoreToTT(int score, int ply) {
+    if (score >= MATE_IN_MAX_PLY) return score + ply;
+    if (score <= -MATE_IN_MAX_PLY) return score - ply;
+    return score;
+}
 
-Minimax::Minimax() {
-    int wpawnScore[64] = {
-        0,  0,  0,  0,  0,  0,  0,  0,
-        5, 10, 10,-20,-20, 10, 10,  5,
-        5, -5,-10,  0,  0,-10, -5,  5,
-        0,  0,  0, 50, 50,  0,  0,  0,
-        5,  5, 10, 25, 25, 10,  5,  5,
-        10, 10, 20, 30, 30, 20, 10, 10,
-        0, 50, 50, 50, 50, 50, 50, 50,
-        0,  0,  0,  0,  0,  0,  0,  0
-    };
-    int wknightScore[64] = {
-        -50,-40,-30,-30,-30,-30,-40,-50,
-        -40,-20,  0,  5,  5,  0,-20,-40,
-        -30,  5, 10, 15, 15, 10,  5,-30,
-        -30,  0, 15, 20, 20, 15,  0,-30,
-        -30,  5, 15, 20, 20, 15,  5,-30,
-        -30,  0, 10, 15, 15, 10,  0,-30,
-        -40,-20,  0,  0,  0,  0,-20,-40,
-        -50,-40,-30,-30,-30,-30,-40,-50
-    };
-    int wbishopScore[64] = {
-        -20,-10,-10,-10,-10,-10,-10,-20,
-        -10,  5,  0,  0,  0,  0,  5,-10,
-        -10, 10, 10, 10, 10, 10, 10,-10,
-        -10,  0, 10, 10, 10, 10,  0,-10,
-        -10,  5,  5, 10, 10,  5,  5,-10,
-        -10,  0,  5, 10, 10,  5,  0,-10,
-        -10,  0,  0,  0,  0,  0,  0,-10,
-        -20,-10,-10,-10,-10,-10,-10,-20
-    };
-    int wrookScore[64] = {
-        0,  0,  0,  5,  5,  0,  0,  0,
-        -5,  0,  0,  0,  0,  0,  0, -5,
-        -5,  0,  0,  0,  0,  0,  0, -5,
-        -5,  0,  0,  0,  0,  0,  0, -5,
-        -5,  0,  0,  0,  0,  0,  0, -5,
-        -5,  0,  0,  0,  0,  0,  0, -5,
-        5, 10, 10, 10, 10, 10, 10,  5,
-        0,  0,  0,  0,  0,  0,  0,  0
-    };
-    int wqueenScore[64] = {
-        -20,-10,-10, -5, -5,-10,-10,-20,
-        -10,  0,  5,  0,  0,  0,  0,-10,
-        -10,  5,  5,  5,  5,  5,  0,-10,
-        0,  0,  5,  5,  5,  5,  0, -5,
-        -5,  0,  5,  5,  5,  5,  0, -5,
-        -10,  0,  5,  5,  5,  5,  0,-10,
-        -10,  0,  0,  0,  0,  0,  0,-10,
-        -20,-10,-10, -5, -5,-10,-10,-20
-    };
-    int wkingScore[64] = {
-        20, 30, 10,  0,  0, 10, 30, 20,
-        20, 20,  0,  0,  0,  0, 20, 20,
-        10,-20,-20,-20,-20,-20,-20,-10,
-        -20,-30,-30,-40,-40,-30,-30,-20,
-        -30,-40,-40,-50,-50,-40,-40,-30,
-        -30,-40,-40,-50,-50,-40,-40,-30,
-        -30,-40,-40,-50,-50,-40,-40,-30,
-        -30,-40,-40,-50,-50,-40,-40,-30
-    };
-    int bpawnScore[64] = {0};
-    int bknightScore[64] = {0};
-    int bbishopScore[64] = {0};
-    int brookScore[64] = {0};
-    int bqueenScore[64] = {0};
-    int bkingScore[64] = {0};
-
-	// Reversing scores for the black side
-	for (int i = 0; i < 8; i++) {
-		for (int j = 0; j < 8; j++) {
-			int index = i * 8 + j;
-			int reverseIndex = (7 - i) * 8 + (7 - j);
-
-			bpawnScore[index] = wpawnScore[reverseIndex];
-			bknightScore[index] = wknightScore[reverseIndex];
-			bbishopScore[index] = wbishopScore[reverseIndex];
-			brookScore[index] = wrookScore[reverseIndex];
-			bqueenScore[index] = wqueenScore[reverseIndex];
-			bkingScore[index] = wkingScore[reverseIndex];
-		}
-	}
-
-    std::copy(std::begin(wpawnScore), std::end(wpawnScore), std::begin(pieceScores[W_PAWN]));
-    std::copy(std::begin(wknightScore), std::end(wknightScore), std::begin(pieceScores[W_KNIGHT]));
-    std::copy(std::begin(wbishopScore), std::end(wbishopScore), std::begin(pieceScores[W_BISHOP]));
-    std::copy(std::begin(wrookScore), std::end(wrookScore), std::begin(pieceScores[W_ROOK]));
-    std::copy(std::begin(wqueenScore), std::end(wqueenScore), std::begin(pieceScores[W_QUEEN]));
-    std::copy(std::begin(wkingScore), std::end(wkingScore), std::begin(pieceScores[W_KING]));
-    std::copy(std::begin(bpawnScore), std::end(bpawnScore), std::begin(pieceScores[B_PAWN]));
-    std::copy(std::begin(bknightScore), std::end(bknightScore), std::begin(pieceScores[B_KNIGHT]));
-    std::copy(std::begin(bbishopScore), std::end(bbishopScore), std::begin(pieceScores[B_BISHOP]));
-    std::copy(std::begin(brookScore), std::end(brookScore), std::begin(pieceScores[B_ROOK]));
-    std::copy(std::begin(bqueenScore), std::end(bqueenScore), std::begin(pieceScores[B_QUEEN]));
-    std::copy(std::begin(bkingScore), std::end(bkingScore), std::begin(pieceScores[B_KING]));
+static inline int scoreFromTT(int score, int ply) {
+    if (score >= MATE_IN_MAX_PLY) return score - ply;
+    if (score <= -MATE_IN_MAX_PLY) return score + ply;
+    return score;
 }
 
-float Minimax::heuristicEval(std::shared_ptr<Chess> chess) {
-    // auto t1 = std::chrono::high_resolution_clock::now();
+Minimax::Minimax() : Minimax(std::make_shared<TranspositionTable>(DEFAULT_HASH_MB)) {}
 
-	int nodeScore[14] = { 0 };
-    float nodeEvaluation = 0.0f;
+Minimax::Minimax(std::shared_ptr<TranspositionTable> sharedTable) : pickerLists(2 * MAX_PLY), table(sharedTable) {}
 
+// Centipawns from the white side. The middlegame and endgame halves of the packed sums and of the pawn structure
+// are blended by the phase, so the king comes out and pawns push as pieces get traded.
+int Minimax::heuristicEval(std::shared_ptr<Chess> chess) {
     if (chess->gameState & GAME_OVER) {
-        // auto t2 = std::chrono::high_resolution_clock::now();
-        // auto ms_int = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1);
-        // heuristicTime += ms_int.count();
         if (chess->colorTurn == WHITE) {
-            return -INFINITE_EVAL;
+            return -INFINITE_EVAL + ply;
         }
         else {
-            return INFINITE_EVAL;
+            return INFINITE_EVAL - ply;
         }
     }
 
-	//// Get number of moves each has
-	//if (chess->colorTurn == WHITE) {
- //       nodeScore[WHITE] = totalMoves;
- //       chess->colorTurn = BLACK;
- //       chess->oppColor = WHITE;
- //       nodeScore[BLACK] = chess->getPseudoLegalMoves().size();
- //       chess->colorTurn = WHITE;
- //       chess->oppColor = BLACK;
-	//}
-	//else {
- //       nodeScore[BLACK] = totalMoves;
- //       chess->colorTurn = WHITE;
- //       chess->oppColor = BLACK;
- //       nodeScore[WHITE] = chess->getPseudoLegalMoves().size();
- //       chess->colorTurn = BLACK;
- //       chess->oppColor = WHITE;
-	//}
-
- //   nodeEvaluation += 10 * (nodeScore[WHITE] - nodeScore[BLACK]);
-
-	// Evaluation depending on the number of pieces each side has
-	int wpawnSize = chess->generator.bitCountSet(chess->currentBoard[W_PAWN]);
-	int wknightSize = chess->generator.bitCountSet(chess->currentBoard[W_KNIGHT]);
-	int wbishopSize = chess->generator.bitCountSet(chess->currentBoard[W_BISHOP]);
-	int wrookSize = chess->generator.bitCountSet(chess->currentBoard[W_ROOK]);
-	int wqueenSize = chess->generator.bitCountSet(chess->currentBoard[W_QUEEN]);
-	int bpawnSize = chess->generator.bitCountSet(chess->currentBoard[B_PAWN]);
-	int bknightSize = chess->generator.bitCountSet(chess->currentBoard[B_KNIGHT]);
-	int bbishopSize = chess->generator.bitCountSet(chess->currentBoard[B_BISHOP]);
-	int brookSize = chess->generator.bitCountSet(chess->currentBoard[B_ROOK]);
-	int bqueenSize = chess->generator.bitCountSet(chess->currentBoard[B_QUEEN]);
-
-    nodeEvaluation += 1000 * (wqueenSize - bqueenSize) + 525 * (wrookSize - brookSize) + 350 * (wbishopSize - bbishopSize)
-        + 350 * (wknightSize - bknightSize) + 100 * (wpawnSize - bpawnSize);
-
-
-	uint64_t boardCopy[14];
-	std::copy(chess->currentBoard, chess->currentBoard + 14, boardCopy);
-
-    // Sum all the pieces scores depending on the square they are placed
-	bool piecesChange = true;
-	uint64_t temp = 1;
-	while (piecesChange) {
-		piecesChange = false;
-        for (int i = (int)W_PAWN; i < (int)UNKNOWN; i++) {
-            if (boardCopy[(Piece)i] > 0) {
-                int square = __builtin_ctzll(boardCopy[(Piece)i]);
-                nodeScore[(Piece)i] += pieceScores[(Piece)i][square];
-                boardCopy[(Piece)i] ^= (temp << square);
-                piecesChange = true;
-            }
-        }
-	}
-
-    nodeEvaluation += nodeScore[W_PAWN] - nodeScore[B_PAWN];
-    nodeEvaluation += nodeScore[W_KNIGHT] - nodeScore[B_KNIGHT];
-    nodeEvaluation += nodeScore[W_BISHOP] - nodeScore[B_BISHOP];
-    nodeEvaluation += nodeScore[W_ROOK] - nodeScore[B_ROOK];
-    nodeEvaluation += nodeScore[W_QUEEN] - nodeScore[B_QUEEN];
-    nodeEvaluation += nodeScore[W_KING] - nodeScore[B_KING];
-    nodeEvaluation /= 100;
-
-    // auto t2 = std::chrono::high_resolution_clock::now();
-    // auto ms_int = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1);
-    // heuristicTime += ms_int.count();
-
-    return nodeEvaluation;
+    Score score = chess->material + chess->pstScore + pawnTable.probe(*chess)->score;
+    int phase = std::min(chess->phase, MAX_PHASE);
+    return (mgValue(score) * phase + egValue(score) * (MAX_PHASE - phase)) / MAX_PHASE;
 }
 
-float Minimax::quiescenceSearch(std::shared_ptr<Chess> chess, float alpha, float beta, int depth) {
+// Negamax quiescence, scores are from the side to move
+int Minimax::quiescenceSearch(std::shared_ptr<Chess> chess, int alpha, int beta, int depth) {
     steps += 1;
-    MoveList moves = chess->getLegalMoves();
+    if ((steps & 1023) == 0) {
+        checkLimits();
+    }
+
+    // Only captures and promotions are searched, unless in check where every evasion is needed
+    bool inCheck = chess->isInCheck();
+    MovePicker picker(*chess, pickerListsAt(ply), Move(), nullptr, Move(), history[chess->colorTurn], inCheck, true);
+    Move move;
+    if(inCheck) {
+        move = picker.nextMove();
+        if(move.move == 0) return -INFINITE_EVAL + ply;
+    }
 
-    float bestValue = heuristicEval(chess);
+    int bestValue = evaluate(chess);
 
-    if(depth == 0 || (chess->gameState & GAME_OVER)) {
+    if(depth == 0 || bestValue >= beta) {
         return bestValue;
     }
+    alpha = std::max(alpha, bestValue);
 
-    if(chess->colorTurn == WHITE) {
-        if(bestValue >= beta) {
-            return bestValue;
+    if(!inCheck) {
+        move = picker.nextMove();
+    }
+
+    for(; move.move != 0; move = picker.nextMove()) {
+        // Delta pruning, even winning the piece for free wouldnt be enough. Promotions can gain more.
+        if(!inCheck && move.getFlags() < KNIGHT_PROMOTION) {
+            int captured = move.getFlags() == EP_CAPTURE ? PIECE_VALUES[1] : PIECE_VALUES[chess->pieceAt[move.getTo()] / 2];
+            if(bestValue + captured + DELTA_MARGIN <= alpha) {
+                continue;
+            }
         }
-        alpha = std::max(alpha, bestValue);
-    } 
-    else {
-        if(bestValue <= alpha) {
+
+        makeSearchMove(chess, move);
+        int value = -quiescenceSearch(chess, -beta, -alpha, depth - 1);
+        undoSearchMove(chess);
+
+        if (isStopped()) {
             return bestValue;
         }
-        beta = std::min(beta, bestValue);
-    }
-    
-
-    for(Move move : moves) {
-        Square kingSq = (Square)(chess->colorTurn + W_KING);
-        bool isCheck = chess->attacksToSquare(kingSq, chess->colorTurn);
-        if(move.getFlags() == CAPTURE_MOVE || isCheck) {
-            chess->makeMove(move);
-            float value = quiescenceSearch(chess, alpha, beta, depth - 1);
-            chess->undoMove();
-            
-            if(chess->colorTurn == WHITE) {
-                if(value >= beta) {
-                    return value;
-                }
-                alpha = std::max(alpha, value);
-            } 
-            else {
-                if(value <= alpha) {
-                    return value;
-                }
-                beta = std::min(beta, value);
+
+        if(value > bestValue) {
+            bestValue = value;
+            if(value >= beta) {
+                return value;
             }
+            alpha = std::max(alpha, value);
         }
     }
 
     return bestValue;
 }
 
-FinalEvaluation Minimax::searchABPruning(Chess chess, int depth) {
+FinalEvaluation Minimax::searchABPruning(const Chess &chess, int depth) {
+    SearchLimits fixedDepth;
+    fixedDepth.depth = depth;
+    return search(chess, fixedDepth);
+}
+
+// Iterative deepening, every iteration starts with the best moves of the previous one in the table
+// Lazy SMP, the helpers search the same root on their own copy and only share the table. Their results make the
+// main thread cut earlier, the move played is always the one of the main thread.
+FinalEvaluation Minimax::search(const Chess &chess, const SearchLimits &searchLimits) {
+    limits = searchLimits;
+    startTime = std::chrono::steady_clock::now();
+    allocateTime();
+    stop = false;
+    canStop = false;
+    table->newSearch();
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < helpers.size(); i++) {
+        Minimax &helper = *helpers[i];
+        helper.table = table;
+        helper.copyMake = copyMake;
+        helper.nullMovePruning = nullMovePruning;
+        helper.lateMoveReductions = lateMoveReductions;
+        helper.reverseFutilityPruning = reverseFutilityPruning;
+        helper.futilityPruning = futilityPruning;
+        helper.seePruning = seePruning;
+        helper.checkExtensions = checkExtensions;
+        helper.singularExtensions = singularExtensions;
+        // Only the depth limit is kept, the main thread stops the helpers when it is done
+        helper.limits = SearchLimits();
+        helper.limits.depth = limits.depth;
+        helper.startTime = startTime;
+        helper.optimumTime = 0;
+        helper.maximumTime = 0;
+        helper.stop = false;
+        helper.canStop = true;
+        workers.emplace_back([this, &helper, &chess, i]() {
+            if (numaPinning) {
+                Numa::bindCurrentThread(helper.numaNode);
+            }
+            helper.iterativeDeepening(chess, (int)i + 1);
+            helper.numaNode = Numa::getCurrentNode();
+        });
+    }
+
+    FinalEvaluation finalEvaluation = iterativeDeepening(chess, 0);
+    numaNode = Numa::getCurrentNode();
+
+    for (std::unique_ptr<Minimax> &helper : helpers) {
+        helper->stop = true;
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    // Nodes per socket, threads that are not pinned count for the node they ended on
+    nodeSteps.assign(Numa::getNodeCount(), 0);
+    nodeSteps[numaNode] += steps;
+    for (std::unique_ptr<Minimax> &helper : helpers) {
+        finalEvaluation.steps += helper->steps;
+        nodeSteps[helper->numaNode] += helper->steps;
+    }
+
+    return finalEvaluation;
+}
+
+FinalEvaluation Minimax::iterativeDeepening(const Chess &chess, int threadIndex) {
     steps = 0;
     heuristicTime = 0;
-    chess.moveGenTime = 0;
-    float alpha = -INFINITE_EVAL;
-    float beta = INFINITE_EVAL;
+    ttStats = {};
+    ply = 0;
+    rootBestMove = Move();
+    extensions[0] = 0;
+    std::fill(std::begin(excludedMoves), std::end(excludedMoves), Move());
+
+    // Killers only make sense for the positions of this search, the history is kept but loses weight
+    std::fill(&killers[0][0], &killers[0][0] + MAX_PLY * 2, Move());
+    for (int color = 0; color < 2; color++) {
+        for (int from = 0; from < 64; from++) {
+            for (int to = 0; to < 64; to++) {
+                history[color][from][to] /= 2;
+            }
+        }
+    }
 
+    // The search works on its own copy, the caller position is left untouched
     std::shared_ptr<Chess> chessRef = std::make_shared<Chess>(chess);
+    chessRef->moveGenTime = 0;
+    searchCopyMake = copyMake || chessRef->totalMoves > MAX_HISTORY - MAX_PLY;
 
-    Evaluation evaluation = searchABPruningExec(chessRef, depth, alpha, beta);
+    // Older positions cant repeat, a capture or pawn move was played since
+    keyCount = 0;
+    for (int i = std::max(0, chessRef->totalMoves - chessRef->halfMoves); i < chessRef->totalMoves; i++) {
+        keyStack[keyCount++] = chessRef->keyHistory[i];
+    }
+    keyStack[keyCount++] = chessRef->key;
 
     FinalEvaluation finalEvaluation;
-    finalEvaluation.result = evaluation.result;
-    finalEvaluation.move = evaluation.move;
+    finalEvaluation.result = 0.0f;
+    finalEvaluation.depth = 0;
+
+    // Half of the helpers start one ply deeper, so the threads are not all on the same iteration
+    int maxDepth = std::min(std::max(limits.depth, 1), MAX_DEPTH);
+    int score = 0;
+    for (int depth = 1 + threadIndex % 2; depth <= maxDepth; depth++) {
+        // Deeper iterations rarely move the score much, a small window around the last one cuts more. If the score
+        // falls outside, that side of the window is widened and the iteration searched again.
+        int delta = ASPIRATION_WINDOW;
+        int alpha = -INFINITE_EVAL;
+        int beta = INFINITE_EVAL;
+        if (depth >= ASPIRATION_DEPTH && std::abs(score) < MATE_IN_MAX_PLY) {
+            alpha = std::max(score - delta, -INFINITE_EVAL);
+            beta = std::min(score + delta, INFINITE_EVAL);
+        }
+
+        while (true) {
+            score = negamax<ROOT_NODE>(chessRef, depth, alpha, beta);
+            if (isStopped()) {
+                break;
+            }
+
+            // A mate score fails against the full window too, there is nothing left to widen
+            delta *= 2;
+            if (score <= alpha && alpha > -INFINITE_EVAL) {
+                alpha = delta > ASPIRATION_MAX ? -INFINITE_EVAL : std::max(score - delta, -INFINITE_EVAL);
+            }
+            else if (score >= beta && beta < INFINITE_EVAL) {
+                beta = delta > ASPIRATION_MAX ? INFINITE_EVAL : std::min(score + delta, INFINITE_EVAL);
+            }
+            else {
+                break;
+            }
+        }
+
+        // The result of an unfinished iteration is thrown away
+        if (isStopped()) {
+            break;
+        }
+
+        finalEvaluation.result = (chessRef->colorTurn == WHITE ? score : -score) / 100.0f;
+        finalEvaluation.move = rootBestMove;
+        finalEvaluation.depth = depth;
+        canStop = true;
+
+        // The next iteration would take several times longer than all the previous ones, it wouldnt finish in time
+        if (optimumTime > 0 && elapsed() >= optimumTime / 2) {
+            break;
+        }
+        // A mate within the depth searched, no shorter one can be found
+        if (!limits.infinite && std::abs(score) >= MATE_IN_MAX_PLY && INFINITE_EVAL - std::abs(score) <= depth) {
+            break;
+        }
+    }
+
     finalEvaluation.steps = steps;
     finalEvaluation.heuristicTime = heuristicTime;
     finalEvaluation.moveGenTime = chessRef->moveGenTime;
-    // std::copy(std::begin(evaluation.moveTree), std::end(evaluation.moveTree), std::begin(finalEvaluation.moveTree));
     return finalEvaluation;
 }
 
-Evaluation Minimax::searchABPruningExec(std::shared_ptr<Chess> chess, int depth, float alpha, float beta) {
+void Minimax::allocateTime() {
+    optimumTime = 0;
+    maximumTime = 0;
+
+    if (limits.infinite) {
+        return;
+    }
+
+    if (limits.moveTime > 0) {
+        maximumTime = std::max(1, limits.moveTime - MOVE_OVERHEAD_MS);
+    }
+    else if (limits.timeLeft > 0) {
+        // The clock is shared between the moves left, 40 are expected when there is no next time control. Most of
+        // the increment can be spent because it comes back after the move.
+        long long available = std::max(1, limits.timeLeft - MOVE_OVERHEAD_MS);
+        int movesToGo = limits.movesToGo > 0 ? std::min(limits.movesToGo, 40) : 40;
+
+        optimumTime = std::min(available, available / movesToGo + limits.increment * 3 / 4);
+        // An iteration can run longer than expected, but it never takes too much of the clock
+        maximumTime = std::min(available, optimumTime * 3);
+    }
+}
+
+// Called every few thousand nodes, reading the clock is not free
+void Minimax::checkLimits() {
+    if ((limits.nodes > 0 && steps >= limits.nodes) || (maximumTime > 0 && elapsed() >= maximumTime)) {
+        stop = true;
+    }
+}
+
+long long Minimax::elapsed() {
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime).count();
+}
+
+// Negamax principal variation search, scores are from the side to move. Only the first move of PV nodes is
+// searched with the full window, the others get a null window that only proves they are not better. A move that
+// beats alpha anyway is searched again as a PV node.
+template<NodeType Node>
+int Minimax::negamax(std::shared_ptr<Chess> chess, int depth, int alpha, int beta) {
+    constexpr bool pvNode = Node != NON_PV_NODE;
+
     steps += 1;
+    if ((steps & 1023) == 0) {
+        checkLimits();
+    }
+
+    if (Node != ROOT_NODE && isDraw(chess)) {
+        return 0;
+    }
 
     if (depth == 0) {
-        // chess->getLegalMoves();
-        Evaluation eval;
-        // eval.result = heuristicEval(chess);
-        eval.result = quiescenceSearch(chess, alpha, beta, 6);
-        return eval;
-    }
-
-    MoveList moveList = chess->getLegalMoves();
-    std::sort(moveList.begin(), moveList.end(), [](const Move& a, const Move& b) {
-        bool killerMove = a.getFlags() == CAPTURE_MOVE && b.getFlags() != CAPTURE_MOVE;
-        bool bothCapture = a.getFlags() == CAPTURE_MOVE && b.getFlags() == CAPTURE_MOVE;
-        bool enpassant = a.getFlags() == EP_CAPTURE && b.getFlags() != EP_CAPTURE && bothCapture;
-
-        return killerMove || enpassant;
-    });
-
-    if(chess->gameState & GAME_OVER) {
-        Evaluation eval;
-        eval.result = heuristicEval(chess);
-        return eval;
-    }
-    
-    if (chess->colorTurn == WHITE) {
-        Evaluation maxEval;
-        maxEval.result = -INFINITE_EVAL;
-        float currentEval = -INFINITE_EVAL;
-
-        for (Move m : moveList) {
-            chess->makeMove(m);
-            currentEval = searchABPruningExec(chess, depth - 1, alpha, beta).result;
-
-            if (currentEval >= maxEval.result) {
-                maxEval.result = currentEval;
-                maxEval.move = m;
-
-                if (maxEval.result >= beta) {
-                    chess->undoMove();
-                    break;
+        return quiescenceSearch(chess, alpha, beta, 6);
+    }
+
+    // The singular search shares the key of the node, it cant use or overwrite its entry
+    Move excludedMove = excludedMoves[ply];
+    bool excluded = excludedMove.move != 0;
+
+    // Cutoffs from the table are only taken in null window nodes, so the principal variation stays intact
+    int alphaOrig = alpha;
+    Move ttMove;
+    TTData ttData;
+    bool ttHit = false;
+    if (!excluded) {
+        ttStats.probes++;
+        ttHit = table->probe(chess->key, ttData);
+    }
+    if (ttHit) {
+        ttStats.hits++;
+        ttData.score = scoreFromTT(ttData.score, ply);
+        ttMove = ttData.move;
+
+        if (!pvNode && ttData.depth >= depth && (ttData.bound == BOUND_EXACT
+            || (ttData.bound == BOUND_LOWER && ttData.score >= beta) || (ttData.bound == BOUND_UPPER && ttData.score <= alpha))) {
+            return ttData.score;
+        }
+    }
+
+    bool inCheck = chess->isInCheck();
+    Move previousMove = ply > 0 ? moveStack[ply - 1] : Move();
+
+    // Static score for the pruning below, not needed in check or in PV nodes
+    int staticEval = -INFINITE_EVAL;
+    if (!pvNode && !inCheck && !excluded) {
+        staticEval = evaluate(chess);
+
+        // Reverse futility, so far above beta that a quiet move of the opponent wont bring it back
+        if (reverseFutilityPruning && depth <= REVERSE_FUTILITY_DEPTH
+            && staticEval - REVERSE_FUTILITY_MARGIN * depth >= beta && std::abs(beta) < MATE_IN_MAX_PLY) {
+            return staticEval;
+        }
+
+        // Null move, if passing still fails high a real move will too. Not twice in a row, and not with only pawns.
+        if (nullMovePruning && depth >= NULL_MOVE_DEPTH && staticEval >= beta && previousMove.move != 0
+            && hasNonPawnMaterial(chess)) {
+            int reducedDepth = std::max(depth - 1 - NULL_MOVE_REDUCTION - depth / 6, 0);
+
+            makeNullMove(chess);
+            extensions[ply] = extensions[ply - 1];
+            int nullScore = -negamax<NON_PV_NODE>(chess, reducedDepth, -beta, -beta + NULL_WINDOW);
+            undoNullMove(chess);
+
+            if (isStopped()) {
+                return 0;
+            }
+            // Mates found after passing are not proven
+            if (nullScore >= beta) {
+                return nullScore >= MATE_IN_MAX_PLY ? beta : nullScore;
+            }
+        }
+    }
+
+    // Quiet moves that dont give check cant raise a hopeless score near the leaves
+    bool futile = futilityPruning && !pvNode && !inCheck && !excluded && depth <= FUTILITY_DEPTH
+        && staticEval + FUTILITY_MARGIN * depth <= alpha;
+
+    int bestScore = -INFINITE_EVAL;
+    Move bestMove;
+
+    // The reply that refuted the previous move last time, indexed by the piece that moved and its square
+    Move counterMove;
+    if (previousMove.move != 0) {
+        counterMove = counterMoves[chess->pieceAt[previousMove.getTo()]][previousMove.getTo()];
+    }
+
+    MovePicker picker(*chess, pickerListsAt(ply), ttMove, killers[ply], counterMove, history[chess->colorTurn], inCheck, false);
+    int legalMoves = 0;
+    Move quietsSearched[MAX_QUIETS_SEARCHED];
+    int quietCount = 0;
+
+    for (Move m = picker.nextMove(); m.move != 0; m = picker.nextMove()) {
+        if (m.move == excludedMove.move) {
+            continue;
+        }
+        legalMoves++;
+        bool quiet = !isCaptureStage(m);
+
+        // Captures that lose too much material by exchange, once a move has been searched
+        if (seePruning && !pvNode && !inCheck && !quiet && legalMoves > 1 && depth <= SEE_PRUNING_DEPTH
+            && chess->see(m) < -SEE_CAPTURE_MARGIN * depth) {
+            continue;
+        }
+
+        // At most one ply per move, and no more than half of the plies so far, so the search always ends
+        bool canExtend = 2 * extensions[ply] < ply && ply + depth < MAX_PLY - EXTENSION_PLY_MARGIN;
+        int extension = 0;
+
+        // Singular, the move of the table is much better than every other one. Mate scores have no margin.
+        if (singularExtensions && Node != ROOT_NODE && canExtend && !excluded && m.move == ttMove.move
+            && depth >= SINGULAR_DEPTH && ttData.bound != BOUND_UPPER && ttData.depth >= depth - 3 && std::abs(ttData.score) < MATE_IN_MAX_PLY) {
+            int singularBeta = ttData.score - SINGULAR_MARGIN * depth;
+
+            excludedMoves[ply] = m;
+            int singularScore = negamax<NON_PV_NODE>(chess, (depth - 1) / 2, singularBeta - NULL_WINDOW, singularBeta);
+            excludedMoves[ply] = Move();
+
+            if (isStopped()) {
+                return bestScore;
+            }
+            if (singularScore < singularBeta) {
+                extension = 1;
+            }
+        }
+
+        makeSearchMove(chess, m);
+        bool givesCheck = chess->isInCheck();
+
+        // Checks are forcing, the reply is searched at the same depth
+        if (checkExtensions && canExtend && givesCheck) {
+            extension = 1;
+        }
+        extensions[ply] = extensions[ply - 1] + extension;
+        int newDepth = depth - 1 + extension;
+
+        // The move still counts as legal, a node with only futile moves is not a stalemate
+        if (futile && quiet && legalMoves > 1 && !givesCheck) {
+            undoSearchMove(chess);
+            continue;
+        }
+
+        int score;
+        if (pvNode && legalMoves == 1) {
+            score = -negamax<PV_NODE>(chess, newDepth, -beta, -alpha);
+        }
+        else {
+            // Late quiet moves are unlikely to be best, they are searched shallower first
+            int reduction = 0;
+            if (lateMoveReductions && depth >= LMR_DEPTH && legalMoves > LMR_MOVES + (pvNode ? 2 : 0) && quiet
+                && !inCheck && !givesCheck && m.move != killers[ply][0].move && m.move != killers[ply][1].move) {
+                reduction = (int)(0.75 + std::log(depth) * std::log(legalMoves) / 2.25);
+                if (pvNode) reduction--;
+                reduction = std::clamp(reduction, 0, newDepth - 1);
+            }
+
+            score = -negamax<NON_PV_NODE>(chess, newDepth - reduction, -alpha - NULL_WINDOW, -alpha);
+            if (reduction > 0 && score > alpha) {
+                score = -negamax<NON_PV_NODE>(chess, newDepth, -alpha - NULL_WINDOW, -alpha);
+            }
+            if (pvNode && score > alpha && score < beta) {
+                score = -negamax<PV_NODE>(chess, newDepth, -beta, -alpha);
+            }
+        }
+        undoSearchMove(chess);
+
+        // The caller ignores the result, nothing is stored in the table either
+        if (isStopped()) {
+            return bestScore;
+        }
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = m;
+
+            if (Node == ROOT_NODE) {
+                rootBestMove = m;
+            }
+
+            if (score >= beta) {
+                if (quiet) {
+                    updateQuietHeuristics(chess, m, previousMove, depth, quietsSearched, quietCount);
                 }
-                alpha = std::max(alpha, maxEval.result);
+                break;
             }
+            alpha = std::max(alpha, score);
+        }
 
-            chess->undoMove();
+        if (quiet && quietCount < MAX_QUIETS_SEARCHED) {
+            quietsSearched[quietCount++] = m;
         }
+    }
+
+    // Checkmate or stalemate
+    if (legalMoves == 0) {
+        // Only the excluded move was legal, it is as singular as it gets
+        if (excluded) return alpha;
+        // Mated sooner is worse, so the winning side goes for the shortest mate and the other one for the longest
+        return inCheck ? -INFINITE_EVAL + ply : 0;
+    }
+
+    if (excluded) {
+        return bestScore;
+    }
+
+    BoundType bound = BOUND_EXACT;
+    if (bestScore <= alphaOrig) bound = BOUND_UPPER;
+    else if (bestScore >= beta) bound = BOUND_LOWER;
+    ttStats.stores++;
+    if (table->store(chess->key, scoreToTT(bestScore, ply), bestMove, depth, bound)) {
+        ttStats.collisions++;
+    }
+
+    return bestScore;
+}
+
+// A quiet move that cuts off becomes a killer of its ply and the countermove of the previous move. Its history goes
+// up and the history of the quiet moves searched before it goes down.
+void Minimax::updateQuietHeuristics(std::shared_ptr<Chess> chess, Move move, Move previousMove, int depth,
+    const Move *quietsSearched, int quietCount) {
+    if (killers[ply][0].move != move.move) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = move;
+    }
+
+    if (previousMove.move != 0) {
+        counterMoves[chess->pieceAt[previousMove.getTo()]][previousMove.getTo()] = move;
+    }
+
+    int bonus = std::min(depth * depth, MAX_HISTORY_BONUS);
+    int (*sideHistory)[64] = history[chess->colorTurn];
+    updateHistory(sideHistory[move.getFrom()][move.getTo()], bonus);
+    for (int i = 0; i < quietCount; i++) {
+        updateHistory(sideHistory[quietsSearched[i].getFrom()][quietsSearched[i].getTo()], -bonus);
+    }
+}
+
+// The score moves towards the bound by a fraction of the bonus, so it never leaves [-MAX_HISTORY_SCORE, MAX_HISTORY_SCORE]
+void Minimax::updateHistory(int &score, int bonus) {
+    score += bonus - score * std::abs(bonus) / MAX_HISTORY_SCORE;
+}
+
+// Scores of the search are from the side to move, the heuristic is from white
+int Minimax::evaluate(std::shared_ptr<Chess> chess) {
+    int eval = heuristicEval(chess);
+    return chess->colorTurn == WHITE ? eval : -eval;
+}
 
-        return maxEval;
+void Minimax::makeSearchMove(std::shared_ptr<Chess> chess, Move move) {
+    if (searchCopyMake) {
+        // Only the position is saved, the history of the game is not touched while searching
+        positionStack[ply] = *chess;
+        chess->applyMove(move);
     }
     else {
-        Evaluation minEval;
-        minEval.result = INFINITE_EVAL;
-        float currentEval = INFINITE_EVAL;
-
-        for (Move m : moveList) {
-            chess->makeMove(m);
-            currentEval = searchABPruningExec(chess, depth - 1, alpha, beta).result;
-
-            if (currentEval <= minEval.result) {
-                minEval.result = currentEval;
-                minEval.move = m;
-                
-                if (minEval.result <= alpha) {
-                    chess->undoMove();
-                    break;
-                }
-                beta = std::min(beta, minEval.result);
-            }
+        chess->makeMove(move);
+    }
+    keyStack[keyCount++] = chess->key;
+    moveStack[ply] = move;
+    ply++;
+}
 
-            chess->undoMove();
+void Minimax::undoSearchMove(std::shared_ptr<Chess> chess) {
+    ply--;
+    keyCount--;
+    if (searchCopyMake) {
+        static_cast<Position&>(*chess) = positionStack[ply];
+    }
+    else {
+        chess->undoMove();
+    }
+}
+
+// The null move is never undone by the game, so it is always copy-made
+void Minimax::makeNullMove(std::shared_ptr<Chess> chess) {
+    positionStack[ply] = *chess;
+    chess->applyNullMove();
+    keyStack[keyCount++] = chess->key;
+    moveStack[ply] = Move();
+    ply++;
+}
+
+void Minimax::undoNullMove(std::shared_ptr<Chess> chess) {
+    ply--;
+    keyCount--;
+    static_cast<Position&>(*chess) = positionStack[ply];
+}
+
+// With only pawns left zugzwang is common, passing would be better than any move
+bool Minimax::hasNonPawnMaterial(std::shared_ptr<Chess> chess) {
+    Piece us = chess->colorTurn;
+    return (chess->currentBoard[us + W_KNIGHT] | chess->currentBoard[us + W_BISHOP]
+        | chess->currentBoard[us + W_ROOK] | chess->currentBoard[us + W_QUEEN]) != 0;
+}
+
+TTStats Minimax::getTTStats() {
+    TTStats stats = ttStats;
+    for (std::unique_ptr<Minimax> &helper : helpers) {
+        stats.probes += helper->ttStats.probes;
+        stats.hits += helper->ttStats.hits;
+        stats.stores += helper->ttStats.stores;
+        stats.collisions += helper->ttStats.collisions;
+    }
+    stats.hashfull = table->getHashfull();
+    return stats;
+}
+
+void Minimax::setHashSize(size_t sizeMB) {
+    table->resize(sizeMB);
+}
+
+// The calling thread is the main one, so threads - 1 helpers are created. With NUMA pinning every helper is
+// created by a thread bound to its node, so its stacks and tables are first touched, and allocated, on that node.
+void Minimax::setThreads(int threads) {
+    threads = std::max(threads, 1);
+    helpers.clear();
+    helpers.resize(threads - 1);
+
+    for (int i = 1; i < threads; i++) {
+        int node = Numa::nodeForThread(i);
+        std::unique_ptr<Minimax> &helper = helpers[i - 1];
+
+        if (numaPinning) {
+            std::thread allocator([this, &helper, node]() {
+                Numa::bindCurrentThread(node);
+                helper = std::make_unique<Minimax>(table);
+            });
+            allocator.join();
         }
+        else {
+            helper = std::make_unique<Minimax>(table);
+        }
+        helper->numaNode = node;
+    }
+}
+
+void Minimax::setNumaPinning(bool enabled) {
+    numaPinning = enabled;
+    setThreads((int)helpers.size() + 1);
+}
 
-        return minEval;
+// Fifty moves rule, or a repetition of any position since the last irreversible move. One repetition is enough, if
+// the position is good for someone it wont be better the second time.
+bool Minimax::isDraw(std::shared_ptr<Chess> chess) {
+    if (chess->halfMoves >= 100) {
+        return true;
     }
-}
\ No newline at end of file
+
+    // The same side must be to move, and it takes at least 4 plies to come back to a position
+    int current = keyCount - 1;
+    int last = std::max(0, current - chess->halfMoves);
+    for (int i = current - 4; i >= last; i -= 2) {
+        if (keyStack[i] == chess->key) {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -5,35 +5,179 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <vector>
 
 #include "../chess/chess.h"
+#include "transposition.h"
+#include "movepicker.h"
+#include "pawntable.h"
 
-const float INFINITE_EVAL = 10000.0f;
+// Scores are integer centipawns from the side to move, a mate is worth INFINITE_EVAL minus the plies to reach it
+const int INFINITE_EVAL = 32000;
+// Deepest ply the search can reach, quiescence included
+const int MAX_PLY = 128;
+// Scores at least this far from 0 are mates
+const int MATE_IN_MAX_PLY = INFINITE_EVAL - MAX_PLY;
+// Deepest iteration of the iterative deepening
+const int MAX_DEPTH = 64;
+// Size of the transposition table of a new Minimax
+const size_t DEFAULT_HASH_MB = 16;
+// Kept from the clock on every move, for the time lost outside of the search
+const int MOVE_OVERHEAD_MS = 30;
 
-typedef struct Evaluation {
-    float result;
-    Move move;
-} Evaluation;
+// Limits of a search, zero means no limit. Times are in milliseconds.
+typedef struct SearchLimits {
+    int depth = MAX_DEPTH;
+    int moveTime = 0; // Fixed time for this move
+    int timeLeft = 0; // Remaining clock of the side to move, the time per move is picked from it
+    int increment = 0;
+    int movesToGo = 0; // Moves until the next time control, 0 if the rest of the game has to be played with it
+    uint64_t nodes = 0;
+    bool infinite = false; // Only the stop flag ends the search
+} SearchLimits;
+
+// Width of the null window searches, the smallest difference between two scores
+const int NULL_WINDOW = 1;
+// Aspiration windows start at this half width around the previous score, and are dropped once wider than the max
+const int ASPIRATION_WINDOW = 25;
+const int ASPIRATION_MAX = 400;
+const int ASPIRATION_DEPTH = 4;
+// Quiet moves that lose history when another one cuts off
+const int MAX_QUIETS_SEARCHED = 64;
+const int MAX_HISTORY_BONUS = 1200;
+
+// Null move is tried from this depth, the reply is searched NULL_MOVE_REDUCTION + depth / 6 plies shallower
+const int NULL_MOVE_DEPTH = 3;
+const int NULL_MOVE_REDUCTION = 3;
+// Quiet moves after the first few are searched shallower, and again at full depth if they beat alpha
+const int LMR_DEPTH = 3;
+const int LMR_MOVES = 3;
+// Near the leaves, nodes whose static score is this many centipawns per depth above beta return it, and quiet moves
+// are skipped when the score plus the margin cant reach alpha
+const int REVERSE_FUTILITY_DEPTH = 6;
+const int REVERSE_FUTILITY_MARGIN = 80;
+const int FUTILITY_DEPTH = 3;
+const int FUTILITY_MARGIN = 100;
+// Captures losing more than this many centipawns per depth by static exchange are skipped near the leaves
+const int SEE_PRUNING_DEPTH = 6;
+const int SEE_CAPTURE_MARGIN = 100;
+// Quiescence skips captures that cant bring the score back to alpha even with this margin over the captured piece
+const int DELTA_MARGIN = 200;
+// The move of the table is extended if every other move fails low against its score minus the margin per depth,
+// in a search of half the depth without it. Extensions stop at half of the plies, and this far from MAX_PLY.
+const int SINGULAR_DEPTH = 6;
+const int SINGULAR_MARGIN = 5;
+const int EXTENSION_PLY_MARGIN = 16;
+
+// The root returns the best move, PV nodes are searched with an open window and the rest with a null window
+enum NodeType {
+    ROOT_NODE,
+    PV_NODE,
+    NON_PV_NODE
+};
 
 typedef struct FinalEvaluation {
-    float result;
+    float result; // From the white side, in pawns
     Move move;
-    int steps;
+    uint64_t steps;
+    int depth; // Last finished iteration
     long long heuristicTime;
     long long moveGenTime;
 } FinalEvaluation;
 
 class Minimax {
 public:
-    int pieceScores[15][64] = {0};
-    int steps = 0;
+    uint64_t steps = 0;
     long long heuristicTime = 0;
+    // Table probes and stores of this thread in the last search, hashfull is left at 0
+    TTStats ttStats = {};
+
+    // With copy-make the position of every ply is saved before making a move and copied back instead of undoing it
+    bool copyMake = false;
+    // Also copy-made when the game history has no room left for a whole search line
+    bool searchCopyMake = false;
+    int ply = 0;
+    Position positionStack[MAX_PLY];
+
+    // Keys of the game since its last capture or pawn move, the root key and one key for each ply of the search
+    uint64_t keyStack[MAX_HISTORY + 1 + MAX_PLY];
+    int keyCount = 0;
+
+    Move rootBestMove;
+
+    // Pruning and reductions, each can be turned off to compare node counts
+    bool nullMovePruning = true;
+    bool lateMoveReductions = true;
+    bool reverseFutilityPruning = true;
+    bool futilityPruning = true;
+    bool seePruning = true;
+    bool checkExtensions = true;
+    bool singularExtensions = true;
+
+    // Move ordering heuristics, each search thread has its own
+    Move moveStack[MAX_PLY];
+    Move killers[MAX_PLY][2] = {};
+    int history[2][64][64] = {};
+    Move counterMoves[14][64] = {};
+
+    // Move picker lists of each ply, a second set for the singular search that runs at the same ply as its node
+    std::vector<PickerLists> pickerLists;
+
+    // Move skipped at each ply by the singular extension search, and the plies extended on the way to it
+    Move excludedMoves[MAX_PLY] = {};
+    int extensions[MAX_PLY] = {};
+
+    // Can be shared by several Minimax searching at the same time
+    std::shared_ptr<TranspositionTable> table;
+    // Only used by this thread, it is kept between searches
+    PawnTable pawnTable;
+
+    // Can be set from another thread to end the search. The first iteration always finishes, so there is a move.
+    std::atomic<bool> stop{false};
+    bool canStop = false;
+    SearchLimits limits;
+    std::chrono::steady_clock::time_point startTime;
+    long long optimumTime = 0; // No new iteration is started after half of it
+    long long maximumTime = 0; // The search is stopped when reached
+
+    // Helper searchers of the Lazy SMP, each with its own heuristics and position
+    std::vector<std::unique_ptr<Minimax>> helpers;
+    // Pins the helpers to the NUMA nodes round robin, only on Linux
+    bool numaPinning = false;
+    int numaNode = 0;
+    // Nodes searched on each NUMA node by the last search
+    std::vector<uint64_t> nodeSteps;
 
     Minimax();
-    float heuristicEval(std::shared_ptr<Chess> chess);
-    float quiescenceSearch(std::shared_ptr<Chess> chess, float alpha, float beta, int depth);
-    FinalEvaluation searchABPruning(Chess chess, int depth);
-    Evaluation searchABPruningExec(std::shared_ptr<Chess> chess, int depth, float alpha, float beta);
+    Minimax(std::shared_ptr<TranspositionTable> sharedTable);
+    int heuristicEval(std::shared_ptr<Chess> chess);
+    int evaluate(std::shared_ptr<Chess> chess);
+    int quiescenceSearch(std::shared_ptr<Chess> chess, int alpha, int beta, int depth);
+    FinalEvaluation searchABPruning(const Chess &chess, int depth);
+    FinalEvaluation search(const Chess &chess, const SearchLimits &searchLimits);
+    FinalEvaluation iterativeDeepening(const Chess &chess, int threadIndex);
+    // Table counters of the last search added up over the helpers, with the hashfull of the table
+    TTStats getTTStats();
+    void allocateTime();
+    void checkLimits();
+    long long elapsed();
+    bool isStopped() { return canStop && stop.load(std::memory_order_relaxed); }
+    PickerLists &pickerListsAt(int ply) { return pickerLists[2 * ply + (excludedMoves[ply].move != 0 ? 1 : 0)]; }
+    template<NodeType Node> int negamax(std::shared_ptr<Chess> chess, int depth, int alpha, int beta);
+    void makeSearchMove(std::shared_ptr<Chess> chess, Move move);
+    void undoSearchMove(std::shared_ptr<Chess> chess);
+    void makeNullMove(std::shared_ptr<Chess> chess);
+    void undoNullMove(std::shared_ptr<Chess> chess);
+    bool hasNonPawnMaterial(std::shared_ptr<Chess> chess);
+    void setHashSize(size_t sizeMB);
+    void setThreads(int threads);
+    void setNumaPinning(bool enabled);
+    bool isDraw(std::shared_ptr<Chess> chess);
+    void updateQuietHeuristics(std::shared_ptr<Chess> chess, Move move, Move previousMove, int depth,
+        const Move *quietsSearched, int quietCount);
+    void updateHistory(int &score, int bonus);
 };
 
 #endif // __MINIMAX__H__
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "movepicker.h"
+#include <utility>
+
+MovePicker::MovePicker(Position &position, PickerLists &lists, Move ttMove, const Move *killers, Move counterMove,
+    const int (*history)[64], bool inCheck, bool quiescence)
+    : position(position), lists(lists), quiescence(quiescence), ttMove(ttMove), counterMove(counterMove), history(history) {
+    lists.captures.count = 0;
+    lists.quiets.count = 0;
+    lists.badCaptures.count = 0;
+    this->killers[0] = killers ? killers[0] : Move();
+    this->killers[1] = killers ? killers[1] : Move();
+
+    if (inCheck) stage = EVASION_INIT;
+    else if (quiescence || ttMove.move == 0) stage = CAPTURE_INIT;
+    else stage = TT_STAGE;
+}
+
+// Most valuable victim first, and between equal victims the least valuable attacker. Underpromotions go last.
+int MovePicker::captureScore(Move move){
+    uint8_t flags = move.getFlags();
+    int score = 0;
+
+    if (flags == EP_CAPTURE) {
+        score = PIECE_VALUES[1] * 8 - 1;
+    }
+    else if (flags == CAPTURE_MOVE || flags >= KNIGHT_PROMOTION_C) {
+        score = PIECE_VALUES[position.pieceAt[move.getTo()] / 2] * 8 - position.pieceAt[move.getFrom()] / 2;
+    }
+
+    if (flags >= KNIGHT_PROMOTION) {
+        Piece promotion = flagToPiece[flags - FLAG_OFFSET];
+        score += promotion == W_QUEEN ? PIECE_VALUES[5] * 8 : -PIECE_VALUES[6] * 8;
+    }
+
+    return score;
+}
+
+void MovePicker::generateCaptures(){
+    if (capturesGenerated) return;
+    position.getCaptureMoves(lists.captures);
+    capturesGenerated = true;
+}
+
+void MovePicker::generateQuiets(){
+    if (quietsGenerated) return;
+    position.getQuietMoves(lists.quiets);
+    quietsGenerated = true;
+}
+
+bool MovePicker::contains(const MoveList &moveList, Move move){
+    for (Move m : moveList) {
+        if (m.move == move.move) return true;
+    }
+    return false;
+}
+
+// One step of a selection sort, the best of the remaining moves is swapped to the front
+Move MovePicker::pickBest(MoveList &moveList, int *scores, size_t &index){
+    size_t best = index;
+    for (size_t i = index + 1; i < moveList.count; i++) {
+        if (scores[i] > scores[best]) best = i;
+    }
+
+    std::swap(moveList.moves[index], moveList.moves[best]);
+    std::swap(scores[index], scores[best]);
+    return moveList.moves[index++];
+}
+
+Move MovePicker::nextMove(){
+    while (true) {
+        switch (stage) {
+            case TT_STAGE: {
+                // The table can hold a move of another position with the same index, it is only played if it is
+                // in the legal list of its stage. That list is kept for later.
+                stage = CAPTURE_INIT;
+                if (isCaptureStage(ttMove)) generateCaptures();
+                else generateQuiets();
+
+                if (contains(isCaptureStage(ttMove) ? lists.captures : lists.quiets, ttMove)) return ttMove;
+                break;
+            }
+            case CAPTURE_INIT: {
+                generateCaptures();
+                for (size_t i = 0; i < lists.captures.count; i++) {
+                    lists.captureScores[i] = captureScore(lists.captures.moves[i]);
+                }
+                index = 0;
+                stage = CAPTURES;
+                break;
+            }
+            case CAPTURES: {
+                // Captures that lose material are kept for after the quiet moves, quiescence drops them
+                while (index < lists.captures.count) {
+                    Move move = pickBest(lists.captures, lists.captureScores, index);
+                    if (move.move == ttMove.move) continue;
+                    if (position.see(move) < 0) {
+                        lists.badCaptures.add(move);
+                        continue;
+                    }
+                    return move;
+                }
+                stage = quiescence ? PICKER_DONE : FIRST_KILLER;
+                break;
+            }
+            case FIRST_KILLER: case SECOND_KILLER: {
+                Move killer = killers[stage - FIRST_KILLER];
+                stage = (PickerStage)(stage + 1);
+
+                if (killer.move != 0 && killer.move != ttMove.move) {
+                    generateQuiets();
+                    if (contains(lists.quiets, killer)) return killer;
+                }
+                break;
+            }
+            case QUIET_INIT: {
+                generateQuiets();
+                for (size_t i = 0; i < lists.quiets.count; i++) {
+                    Move move = lists.quiets.moves[i];
+                    lists.quietScores[i] = history[move.getFrom()][move.getTo()];
+                    if (move.move == counterMove.move) lists.quietScores[i] += MAX_HISTORY_SCORE;
+                }
+                index = 0;
+                stage = QUIETS;
+                break;
+            }
+            case QUIETS: {
+                while (index < lists.quiets.count) {
+                    Move move = pickBest(lists.quiets, lists.quietScores, index);
+                    if (move.move != ttMove.move && move.move != killers[0].move && move.move != killers[1].move) {
+                        return move;
+                    }
+                }
+                index = 0;
+                stage = BAD_CAPTURES;
+                break;
+            }
+            case BAD_CAPTURES: {
+                // Already in order, they were put aside while picking
+                if (index < lists.badCaptures.count) return lists.badCaptures.moves[index++];
+                stage = PICKER_DONE;
+                break;
+            }
+            case EVASION_INIT: {
+                // Kept in the lists.captures list, the table move first, then lists.captures, then lists.quiets by history
+                position.getEvasionMoves(lists.captures);
+                for (size_t i = 0; i < lists.captures.count; i++) {
+                    Move move = lists.captures.moves[i];
+                    if (move.move == ttMove.move) lists.captureScores[i] = 1 << 30;
+                    else if (isCaptureStage(move)) lists.captureScores[i] = (1 << 20) + captureScore(move);
+                    else lists.captureScores[i] = history ? history[move.getFrom()][move.getTo()] : 0;
+                }
+                index = 0;
+                stage = EVASIONS;
+                break;
+            }
+            case EVASIONS: {
+                if (index < lists.captures.count) return pickBest(lists.captures, lists.captureScores, index);
+                stage = PICKER_DONE;
+                break;
+            }
+            case PICKER_DONE: {
+                return Move();
+            }
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef __MOVEPICKER__
+#define __MOVEPICKER__
+#include <cstdint>
+
+#include "../chess/position.h"
+
+// Order of the moves returned by the picker. Evasions are picked in a single stage, since there are few of them.
+enum PickerStage : uint8_t {
+    TT_STAGE,
+    CAPTURE_INIT,
+    CAPTURES,
+    FIRST_KILLER,
+    SECOND_KILLER,
+    QUIET_INIT,
+    QUIETS,
+    BAD_CAPTURES,
+    EVASION_INIT,
+    EVASIONS,
+    PICKER_DONE
+};
+
+// Captures and promotions are generated together, everything else is a quiet move
+inline bool isCaptureStage(Move move){ return move.getFlags() >= CAPTURE_MOVE; }
+
+// Upper bound of the history scores, the updates shrink towards it
+const int MAX_HISTORY_SCORE = 16384;
+
+// Lists and scores of one picker, about 3.6 KB. On the stack of every node they would take half a MB in a deep
+// search, more than the stack of the wasm build, so the searcher keeps them for each ply.
+typedef struct PickerLists {
+    MoveList captures;
+    MoveList quiets;
+    MoveList badCaptures;
+    int captureScores[MAX_MOVES];
+    int quietScores[MAX_MOVES];
+} PickerLists;
+
+// Returns the legal moves one by one, best first: the move of the table, captures by most valuable victim and
+// least valuable attacker, the killers, the quiet moves by history with a bonus for the countermove, then the
+// captures that lose material by static exchange. The lists are only generated when their stage is reached, and
+// each call only looks for the best remaining move, so nothing is sorted when the first moves cut off.
+class MovePicker{
+public:
+    Position &position;
+    // Cleared by the constructor, only one picker can use them at a time
+    PickerLists &lists;
+    PickerStage stage;
+    bool quiescence;
+
+    Move ttMove;
+    Move killers[2];
+    Move counterMove;
+    // History of the side to move, indexed by from and to squares
+    const int (*history)[64];
+
+    bool capturesGenerated = false;
+    bool quietsGenerated = false;
+    size_t index = 0;
+
+    // In quiescence only captures that dont lose material, or every evasion when in check, are returned
+    MovePicker(Position &position, PickerLists &lists, Move ttMove, const Move *killers, Move counterMove, const int (*history)[64],
+        bool inCheck, bool quiescence);
+    // Returns an empty move when there are no moves left
+    Move nextMove();
+
+    int captureScore(Move move);
+    void generateCaptures();
+    void generateQuiets();
+    bool contains(const MoveList &moveList, Move move);
+    static Move pickBest(MoveList &moveList, int *scores, size_t &index);
+};
+
+#endif // __MOVEPICKER__
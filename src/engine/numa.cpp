@@ -0,0 +1,94 @@
+#include "numa.h"
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+// Lists like "0-15,32-47"
+std::vector<int> Numa::parseCpuList(const std::string &cpuList){
+    std::vector<int> cpus;
+    std::stringstream listStream(cpuList);
+    std::string range;
+
+    while (std::getline(listStream, range, ',')) {
+        if (range.empty() || range == "\n") continue;
+
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+
+    return cpus;
+}
+
+static std::vector<std::vector<int>> readNodes(){
+    std::vector<std::vector<int>> nodes;
+
+    #ifdef __linux__
+    // Node numbers are consecutive from 0, the first missing one ends the list
+    for (int node = 0; ; node++) {
+        std::ifstream cpuFile("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string cpuList;
+        if (!cpuFile || !std::getline(cpuFile, cpuList)) break;
+
+        std::vector<int> cpus = Numa::parseCpuList(cpuList);
+        // Nodes with memory but no CPUs cant run threads
+        if (!cpus.empty()) nodes.push_back(cpus);
+    }
+    #endif
+
+    if (nodes.empty()) {
+        nodes.push_back(std::vector<int>());
+    }
+
+    return nodes;
+}
+
+const std::vector<std::vector<int>>& Numa::getNodes(){
+    static const std::vector<std::vector<int>> nodes = readNodes();
+    return nodes;
+}
+
+int Numa::getNodeCount(){
+    return (int)getNodes().size();
+}
+
+int Numa::nodeForThread(int threadIndex){
+    return threadIndex % getNodeCount();
+}
+
+bool Numa::bindCurrentThread(int node){
+    #ifdef __linux__
+    const std::vector<std::vector<int>> &nodes = getNodes();
+    if (node < 0 || node >= (int)nodes.size() || nodes[node].empty()) return false;
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (int cpu : nodes[node]) {
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &cpuSet);
+    }
+
+    return sched_setaffinity(0, sizeof(cpuSet), &cpuSet) == 0;
+    #else
+    (void)node;
+    return false;
+    #endif
+}
+
+int Numa::getCurrentNode(){
+    #ifdef __linux__
+    int cpu = sched_getcpu();
+    const std::vector<std::vector<int>> &nodes = getNodes();
+    for (size_t node = 0; node < nodes.size(); node++) {
+        for (int nodeCpu : nodes[node]) {
+            if (nodeCpu == cpu) return (int)node;
+        }
+    }
+    #endif
+    return 0;
+}
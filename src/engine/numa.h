@@ -0,0 +1,22 @@
+#ifndef __NUMA__
+#define __NUMA__
+#include <vector>
+#include <string>
+
+// CPUs of every NUMA node, read once from sysfs on Linux. Other systems, and machines without NUMA, see a single
+// node with no CPU list and pinning does nothing.
+class Numa{
+public:
+    static const std::vector<std::vector<int>>& getNodes();
+    static int getNodeCount();
+    // Threads are spread round robin over the nodes, so every socket gets the same share of the search
+    static int nodeForThread(int threadIndex);
+    // Restricts the calling thread to the CPUs of a node. Memory it touches first is then allocated on that node.
+    static bool bindCurrentThread(int node);
+    // Node of the CPU the calling thread runs on, 0 if unknown
+    static int getCurrentNode();
+
+    static std::vector<int> parseCpuList(const std::string &cpuList);
+};
+
+#endif // __NUMA__
@@ -0,0 +1,87 @@
+#include "pawntable.h"
+
+const uint64_t FILE_A = 0x0101010101010101ULL;
+
+static inline uint64_t fileMask(int file){ return FILE_A << file; }
+
+static inline uint64_t adjacentFiles(int file){
+    return (file > 0 ? fileMask(file - 1) : 0) | (file < 7 ? fileMask(file + 1) : 0);
+}
+
+// Ranks strictly in front of a square, seen from Us
+template<Piece Us>
+static inline uint64_t ranksAhead(int sq){
+    return Us == WHITE ? (sq >= 56 ? 0 : ~0ULL << (8 * (sq / 8 + 1))) : (sq < 8 ? 0 : ~0ULL >> (8 * (8 - sq / 8)));
+}
+
+PawnTable::PawnTable(){
+    entries = std::vector<PawnEntry>(1 << PAWN_TABLE_BITS);
+    clear();
+}
+
+void PawnTable::clear(){
+    for (PawnEntry &entry : entries) {
+        entry = PawnEntry();
+    }
+    probes = 0;
+    hits = 0;
+}
+
+PawnEntry* PawnTable::probe(Position &position){
+    probes++;
+    PawnEntry &entry = entries[position.pawnKey & (entries.size() - 1)];
+    if (entry.key == position.pawnKey) {
+        hits++;
+        return &entry;
+    }
+
+    entry.key = position.pawnKey;
+    evaluate(position, entry);
+    return &entry;
+}
+
+void PawnTable::evaluate(Position &position, PawnEntry &entry){
+    entry.score = evaluateSide<WHITE>(position, entry.passed[WHITE]) - evaluateSide<BLACK>(position, entry.passed[BLACK]);
+}
+
+template<Piece Us>
+Score PawnTable::evaluateSide(Position &position, uint64_t &passed){
+    constexpr Piece Them = Us == WHITE ? BLACK : WHITE;
+    constexpr int forward = Us == WHITE ? 8 : -8;
+
+    uint64_t ourPawns = position.currentBoard[Us + W_PAWN];
+    uint64_t theirPawns = position.currentBoard[Them + W_PAWN];
+    Score score = 0;
+    passed = 0;
+
+    uint64_t pawns = ourPawns;
+    while (pawns) {
+        int sq = __builtin_ctzll(pawns);
+        pawns &= pawns - 1;
+        int file = sq % 8;
+        uint64_t ahead = ranksAhead<Us>(sq);
+
+        // Only the rear pawn of a file is counted as doubled, against the ones in front of it
+        if (ourPawns & fileMask(file) & ahead) {
+            score += DOUBLED_PAWN;
+        }
+
+        if ((ourPawns & adjacentFiles(file)) == 0) {
+            score += ISOLATED_PAWN;
+        }
+        // No pawn beside or behind can defend it when it advances, and the square in front is guarded by a pawn
+        else if ((ourPawns & adjacentFiles(file) & ~ahead) == 0
+            && (Position::generator.pawnAttacks[Us][sq + forward] & theirPawns)) {
+            score += BACKWARD_PAWN;
+        }
+
+        if ((theirPawns & (fileMask(file) | adjacentFiles(file)) & ahead) == 0
+            && (ourPawns & fileMask(file) & ahead) == 0) {
+            passed |= 1ULL << sq;
+            int rank = Us == WHITE ? sq / 8 : 7 - sq / 8;
+            score += PASSED_PAWN[rank];
+        }
+    }
+
+    return score;
+}
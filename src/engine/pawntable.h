@@ -0,0 +1,46 @@
+#ifndef __PAWNTABLE__
+#define __PAWNTABLE__
+#include <cstdint>
+#include <vector>
+
+#include "../chess/position.h"
+
+// Entries of the pawn table, 2^14 of them per search thread
+const int PAWN_TABLE_BITS = 14;
+
+// Pawn structure terms, middlegame and endgame
+const Score DOUBLED_PAWN = makeScore(-10, -20); // For every pawn behind another one of its color on the file
+const Score ISOLATED_PAWN = makeScore(-10, -15);
+const Score BACKWARD_PAWN = makeScore(-8, -10);
+// Indexed by the rank counted from the side of the pawn
+const Score PASSED_PAWN[8] = {
+    makeScore(0, 0), makeScore(5, 10), makeScore(10, 20), makeScore(15, 35),
+    makeScore(25, 60), makeScore(40, 100), makeScore(60, 150), makeScore(0, 0)
+};
+
+// Pawn structure of one pawn key. Positions without pawns have key 0, like the cleared entries, which is also
+// their right score.
+typedef struct PawnEntry {
+    uint64_t key;
+    Score score; // From the white side
+    uint64_t passed[2]; // Passed pawns of each color
+} PawnEntry;
+
+// Pawns move rarely, most positions of a search share their structure with many others. Each search thread has
+// its own table, so there are no races and no locks.
+class PawnTable{
+public:
+    std::vector<PawnEntry> entries;
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+
+    PawnTable();
+    void clear();
+    // The entry of the pawns of the position, evaluated first if it was not in the table
+    PawnEntry* probe(Position &position);
+
+    static void evaluate(Position &position, PawnEntry &entry);
+    template<Piece Us> static Score evaluateSide(Position &position, uint64_t &passed);
+};
+
+#endif // __PAWNTABLE__
@@ -0,0 +1,120 @@
+#include "transposition.h"
+#include <algorithm>
+
+static inline uint64_t packData(int score, Move move, int depth, BoundType bound, uint8_t generation){
+    return (uint64_t)(uint32_t)score | ((uint64_t)move.move << 32) | ((uint64_t)(depth & 0xff) << 48)
+        | ((uint64_t)bound << 56) | ((uint64_t)(generation & 63) << 58);
+}
+
+static inline int dataDepth(uint64_t data){ return (data >> 48) & 0xff; }
+static inline BoundType dataBound(uint64_t data){ return (BoundType)((data >> 56) & 3); }
+static inline uint8_t dataGeneration(uint64_t data){ return (data >> 58) & 63; }
+
+TranspositionTable::TranspositionTable(size_t sizeMB){
+    resize(sizeMB);
+}
+
+void TranspositionTable::resize(size_t sizeMB){
+    // Round down to a power of 2 so the index is a mask of the key, at least one bucket
+    size_t count = 1;
+    while(count * 2 * sizeof(TTBucket) <= sizeMB * 1024 * 1024){
+        count *= 2;
+    }
+
+    buckets = std::vector<TTBucket>(count);
+    mask = count - 1;
+    clear();
+}
+
+void TranspositionTable::clear(){
+    for(TTBucket &bucket : buckets) {
+        for(TTEntry &entry : bucket.entries) {
+            entry.check.store(0, std::memory_order_relaxed);
+            entry.data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    generation = 0;
+}
+
+void TranspositionTable::newSearch(){
+    generation = (generation + 1) & 63;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTData &ttData){
+    TTBucket &bucket = buckets[key & mask];
+
+    for(TTEntry &entry : bucket.entries) {
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+        if((check ^ data) == key && dataBound(data) != BOUND_NONE) {
+            ttData.score = (int32_t)(uint32_t)data;
+            ttData.move.move = (uint16_t)(data >> 32);
+            ttData.depth = dataDepth(data);
+            ttData.bound = dataBound(data);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool TranspositionTable::store(uint64_t key, int score, Move move, int depth, BoundType bound){
+    TTBucket &bucket = buckets[key & mask];
+
+    // The same position is overwritten unless the new result is a bound of a much shallower search, otherwise the
+    // entry with the lowest depth is replaced. Entries of older searches count as much shallower, so the table doesnt
+    // fill up with stale positions.
+    TTEntry *replace = &bucket.entries[0];
+    int replaceValue = 1 << 30;
+    bool samePosition = false;
+    for(TTEntry &entry : bucket.entries) {
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+
+        if((check ^ data) == key) {
+            // A deep result is worth more than a bound of a much shallower search, like a reduced one
+            if(bound != BOUND_EXACT && depth + TT_DEPTH_MARGIN < dataDepth(data)) return false;
+
+            replace = &entry;
+            samePosition = true;
+
+            // Keep the old best move if this search didnt find one
+            if(move.move == 0) move.move = (uint16_t)(data >> 32);
+            break;
+        }
+
+        if(dataBound(data) == BOUND_NONE) {
+            replace = &entry;
+            replaceValue = -(1 << 30);
+            continue;
+        }
+
+        int age = (generation - dataGeneration(data)) & 63;
+        int value = dataDepth(data) - 8 * age;
+        if(value < replaceValue) {
+            replace = &entry;
+            replaceValue = value;
+        }
+    }
+
+    bool collision = !samePosition && dataBound(replace->data.load(std::memory_order_relaxed)) != BOUND_NONE;
+
+    uint64_t data = packData(score, move, depth, bound, generation);
+    replace->check.store(key ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+    return collision;
+}
+
+int TranspositionTable::getHashfull(){
+    size_t sampleBuckets = std::min<size_t>(buckets.size(), 1000 / BUCKET_SIZE);
+    int used = 0;
+    for(size_t i = 0; i < sampleBuckets; i++) {
+        for(TTEntry &entry : buckets[i].entries) {
+            uint64_t data = entry.data.load(std::memory_order_relaxed);
+            if(dataBound(data) != BOUND_NONE && dataGeneration(data) == generation) used++;
+        }
+    }
+    return used * 1000 / (int)(sampleBuckets * BUCKET_SIZE);
+}
@@ -0,0 +1,73 @@
+#ifndef __TRANSPOSITION__
+#define __TRANSPOSITION__
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <vector>
+
+#include "../chess/move_structs.h"
+
+// How the stored score relates to the real value of the position
+enum BoundType : uint8_t {
+    BOUND_NONE,
+    BOUND_EXACT,
+    BOUND_LOWER, // The search failed high, the real score is at least this
+    BOUND_UPPER  // The search failed low, the real score is at most this
+};
+
+// Unpacked entry returned by probe
+typedef struct TTData {
+    int score;
+    Move move;
+    int depth;
+    BoundType bound;
+} TTData;
+
+// The key is stored xored with the data, so an entry torn by two threads writing at the same time fails the key
+// check instead of returning data of another position. No locks are needed.
+// Data layout: score bits 0-31, move 32-47, depth 48-55, bound 56-57, generation 58-63.
+typedef struct TTEntry {
+    std::atomic<uint64_t> check;
+    std::atomic<uint64_t> data;
+} TTEntry;
+
+const int BUCKET_SIZE = 4;
+// An entry of the same position is kept over a bound from a search this many plies shallower
+const int TT_DEPTH_MARGIN = 3;
+
+// One cache line, a probe only touches one bucket
+typedef struct alignas(64) TTBucket {
+    TTEntry entries[BUCKET_SIZE];
+} TTBucket;
+
+static_assert(sizeof(TTBucket) == 64, "Buckets must fill exactly one cache line");
+
+// Counters to size the table. Every searcher counts its own probes and stores, so the threads dont share a cache line
+// for them, and Minimax::getTTStats adds them up.
+typedef struct TTStats {
+    uint64_t probes;
+    uint64_t hits;
+    uint64_t stores;
+    uint64_t collisions; // Stores that replaced an entry of another position
+    int hashfull; // Used entries of the current search per thousand, sampled from the first buckets
+} TTStats;
+
+// Transposition table shared by every search thread. The size is rounded down to a power of 2 buckets.
+class TranspositionTable{
+public:
+    std::vector<TTBucket> buckets;
+    uint64_t mask = 0;
+    uint8_t generation = 0;
+
+    TranspositionTable(size_t sizeMB);
+    void resize(size_t sizeMB);
+    void clear();
+    // Called before every search, older entries are replaced first
+    void newSearch();
+    bool probe(uint64_t key, TTData &ttData);
+    // Returns true when an entry of another position was replaced
+    bool store(uint64_t key, int score, Move move, int depth, BoundType bound);
+    int getHashfull();
+};
+
+#endif // __TRANSPOSITION__
@@ -9,13 +9,20 @@
 #include <thread>
 #include <chrono>
 #include <memory>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
 
 #include "chess/chess.h"
+#include "chess/perft.h"
 #include "engine/minimax.h"
+#include "engine/numa.h"
 
 #define SCREEN_WIDTH 1024
 #define SCREEN_HEIGHT 576
 #define SQUARE_SIZE (SCREEN_HEIGHT/8)
+// Thinking time of the engine in the GUI
+#define SEARCH_TIME_MS 1000
 
 void initSDL(void);
 void prepareScene(void);
@@ -23,8 +30,13 @@ void presentScene(void);
 void handleClick(void);
 void draw_circle(SDL_Point center, int radius, SDL_Color color);
 void updateEvalTexts(void);
-void updateEval(void);
+void updateEval(Chess position);
 void doPerft(void);
+int runCommand(int argc, char* argv[]);
+int runBench(int depth);
+int runSmpBench(int depth, bool numa);
+int runPruneBench(int depth);
+int runHistoryTest(void);
 
 typedef struct {
 	SDL_Renderer * renderer;
@@ -36,7 +48,9 @@ App app;
 std::map<Piece, SDL_Texture*> pieceImage;
 Chess chess;
 Minimax mm;
+// Written by the search thread and read by the GUI thread
 FinalEvaluation evaluation;
+std::mutex evaluationMutex;
 std::vector<Piece> board = chess.getCurrentBoard();
 MoveList moves = chess.getLegalMoves();
 int selectedPiece = -1;
@@ -61,12 +75,17 @@ SDL_Rect evalRect;
 SDL_Texture* moveText;
 SDL_Rect moveRect;
 
-bool updatingEval = false;
+std::atomic<bool> updatingEval{false};
 bool updateEvalRequest = false;
-int evalCounter = 0;
+std::atomic<int> evalCounter{0};
 int currentEval = 0;
 
 int main(int argc, char* argv[]) {
+	// Command line mode for benchmarks, the GUI is not opened
+	if (argc > 1) {
+		return runCommand(argc, argv);
+	}
+
     SDL_SetMainReady();
 
 	initSDL();
@@ -86,11 +105,13 @@ int main(int argc, char* argv[]) {
 	pieceImage[B_KING] = IMG_LoadTexture(app.renderer, "./GUI/assets/black_king.png");
 
 	Sans = TTF_OpenFont("Sans.ttf", 36);
+	mm.setThreads(std::max(1u, std::thread::hardware_concurrency()));
 
+	// The search thread gets its own copy, the board can change while it searches
 	updatingEval = true;
 	updateEvalTexts();
-	std::thread evalThread(updateEval);
-	evalThread.detach();
+	// Joined before the next search starts and before exiting, it uses the global searcher and its table
+	std::thread evalThread(updateEval, chess);
 	// std::thread perftThread(doPerft);
 	// perftThread.detach();
 
@@ -100,8 +121,9 @@ int main(int argc, char* argv[]) {
 			updatingEval = true;
 			updateEvalTexts();
 
-			std::thread newEvalThread(updateEval);
-			newEvalThread.detach();
+			// The last search has finished, so the join returns right away
+			if (evalThread.joinable()) evalThread.join();
+			evalThread = std::thread(updateEval, chess);
 			updateEvalRequest = false;
 		}
 
@@ -114,6 +136,7 @@ int main(int argc, char* argv[]) {
 			{
 			case SDL_QUIT:
 				run = false;
+				mm.stop = true;
 				break;
 			case SDL_MOUSEBUTTONDOWN:
 				if (event.button.button == SDL_BUTTON_LEFT) {
@@ -128,6 +151,10 @@ int main(int argc, char* argv[]) {
 		presentScene();
 	}
 
+	// A search that had not started yet clears the stop flag, then it runs for its whole time before returning
+	mm.stop = true;
+	if (evalThread.joinable()) evalThread.join();
+
     SDL_Quit();
 
 	return 0;
@@ -273,7 +300,11 @@ void handleClick(void) {
 					std::cout << "PieceType: " << pieces[(int)m.pieceType] << std::endl;
 					std::cout << "CPieceColor" << pieces[(int)m.cPieceColor] << std::endl;
 					std::cout << "CPieceType" << pieces[(int)m.cPieceType] << std::endl;*/
-					chess.makeMove(m);
+					// The game history is full, the move is not played
+					if (!chess.makeMove(m)) {
+						std::cout << "The game is too long, no more moves can be played" << std::endl;
+						break;
+					}
 					board = chess.getCurrentBoard();
 					moves = chess.getLegalMoves();
 					std::cout << "Fen value: " << chess.getFen() << std::endl;
@@ -304,11 +335,17 @@ void draw_circle(SDL_Point center, int radius, SDL_Color color)
 }
 
 void updateEvalTexts() {
+	FinalEvaluation shown;
+	{
+		std::lock_guard<std::mutex> lock(evaluationMutex);
+		shown = evaluation;
+	}
+
 	char evalBuffer[10];
-	snprintf(evalBuffer, sizeof evalBuffer, "%03.2f", evaluation.result);
-	const char* moveBuffer = SquareText[evaluation.move.getTo()];
+	snprintf(evalBuffer, sizeof evalBuffer, "%03.2f", shown.result);
+	const char* moveBuffer = SquareText[shown.move.getTo()];
 	char movePiece[5] = {};
-	switch (chess.pieceAt[evaluation.move.getFrom()]) {
+	switch (chess.pieceAt[shown.move.getFrom()]) {
 	case W_BISHOP:
 	case B_BISHOP:
 		movePiece[0] = 'B';
@@ -333,7 +370,7 @@ void updateEvalTexts() {
 		break;
 	}
 
-	if (evaluation.move.getFlags() == CAPTURE_MOVE) {
+	if (shown.move.getFlags() == CAPTURE_MOVE) {
 		movePiece[1] = 'x';
 	}
 
@@ -356,20 +393,26 @@ void updateEvalTexts() {
 	SDL_FreeSurface(moveSurface);
 }
 
-void updateEval() {
+void updateEval(Chess position) {
 	auto t1 = std::chrono::high_resolution_clock::now();
 
-	Chess chessboardCopy = chess;
-	evaluation = mm.searchABPruning(chessboardCopy, 4);
+	SearchLimits limits;
+	limits.moveTime = SEARCH_TIME_MS;
+	FinalEvaluation result = mm.search(position, limits);
+	{
+		std::lock_guard<std::mutex> lock(evaluationMutex);
+		evaluation = result;
+	}
 
 	auto t2 = std::chrono::high_resolution_clock::now();
 	auto ms_int = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
 
-	std::cout << evaluation.steps / (ms_int.count()) << " knodes\n";
+	std::cout << result.steps / (ms_int.count() + 1) << " knodes\n";
 	std::cout << ms_int.count() << "ms\n";
-	std::cout << evaluation.steps << " steps\n";
-	std::cout << evaluation.heuristicTime / 1000 << "ms heuristic\n";
-	std::cout << evaluation.moveGenTime / 1000 << "ms move gen\n\n";
+	std::cout << result.steps << " steps\n";
+	std::cout << "depth " << result.depth << "\n";
+	std::cout << result.heuristicTime / 1000 << "ms heuristic\n";
+	std::cout << result.moveGenTime / 1000 << "ms move gen\n\n";
 
 	// for(Move m : evaluation.moveTree) {
 	// 	if(m.move == 0) {
@@ -389,11 +432,11 @@ void doPerft() {
 	std::cout << "\nCalculating perft performance...\n" << std::endl;
 	int depth = 5;
 	Chess chessboardCopy = chess;
-	chessboardCopy.moveGenTime = 0;
 
 	auto t1 = std::chrono::high_resolution_clock::now();
 
-	PerftResults results = chessboardCopy.perft(depth);
+	// Uses every hardware thread, each one with its own copy of the board
+	PerftResults results = perftParallel(chessboardCopy, depth);
 
 	auto t2 = std::chrono::high_resolution_clock::now();
 	auto ms_int = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
@@ -405,4 +448,281 @@ void doPerft() {
 	std::cout << "Enpassant: " + std::to_string(results.enpassant) << std::endl;
 	std::cout << "Execution time: " + std::to_string(ms_int.count()) + "ms" << std::endl;
 	std::cout << std::to_string(results.totalCount / ms_int.count()) + " knodes" << std::endl;
-}
\ No newline at end of file
+}
+
+// Usage:
+//   BalaramaEngine perft <depth> [fen]
+//   BalaramaEngine perftsuite [epd file] [max depth]
+int runCommand(int argc, char* argv[]) {
+	std::string command = argv[1];
+
+	if (command == "perft" && argc > 2) {
+		int depth = std::atoi(argv[2]);
+		Chess position;
+		if (argc > 3 && !position.loadFen(argv[3])) {
+			std::cout << "Invalid fen: " << argv[3] << std::endl;
+			return 1;
+		}
+
+		auto t1 = std::chrono::high_resolution_clock::now();
+		uint64_t nodes = perftBulkParallel(position, depth);
+		auto t2 = std::chrono::high_resolution_clock::now();
+		auto ms_int = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
+
+		std::cout << "Nodes: " << nodes << std::endl;
+		std::cout << "Execution time: " << ms_int.count() << "ms" << std::endl;
+		std::cout << nodes / (ms_int.count() + 1) << " knodes" << std::endl;
+		return 0;
+	}
+	else if (command == "perftsuite") {
+		std::string path = argc > 2 ? argv[2] : "perft.epd";
+		int maxDepth = argc > 3 ? std::atoi(argv[3]) : 6;
+		return runPerftSuite(path, maxDepth) ? 0 : 1;
+	}
+	else if (command == "search" && argc > 2) {
+		Chess position;
+		if (argc > 3 && !position.loadFen(argv[3])) {
+			std::cout << "Invalid fen: " << argv[3] << std::endl;
+			return 1;
+		}
+
+		SearchLimits limits;
+		limits.moveTime = std::atoi(argv[2]);
+		FinalEvaluation result = mm.search(position, limits);
+
+		std::cout << "Best move: " << squareToString((Square)result.move.getFrom()) << squareToString((Square)result.move.getTo())
+			<< ", eval " << result.result << ", depth " << result.depth << ", " << result.steps << " nodes" << std::endl;
+		return 0;
+	}
+	else if (command == "bench") {
+		return runBench(argc > 2 ? std::atoi(argv[2]) : 4);
+	}
+	else if (command == "smpbench") {
+		bool numa = argc > 3 && std::string(argv[3]) == "numa";
+		return runSmpBench(argc > 2 ? std::atoi(argv[2]) : 8, numa);
+	}
+	else if (command == "prunebench") {
+		return runPruneBench(argc > 2 ? std::atoi(argv[2]) : 7);
+	}
+	else if (command == "historytest") {
+		return runHistoryTest();
+	}
+
+	std::cout << "Usage: BalaramaEngine perft <depth> [fen]" << std::endl;
+	std::cout << "       BalaramaEngine perftsuite [epd file] [max depth]" << std::endl;
+	std::cout << "       BalaramaEngine search <time ms> [fen]" << std::endl;
+	std::cout << "       BalaramaEngine bench [depth]" << std::endl;
+	std::cout << "       BalaramaEngine smpbench [depth] [numa]" << std::endl;
+	std::cout << "       BalaramaEngine prunebench [depth]" << std::endl;
+	std::cout << "       BalaramaEngine historytest" << std::endl;
+	return 1;
+}
+
+// Compares make/undo with copy-make, both in perft and in the search. The node counts of both modes must match.
+int runBench(int depth) {
+	const char* benchFens[] = {
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"r1bq1rk1/pp2bppp/2n2n2/3p4/3P4/2NBPN2/PP3PPP/R2QK2R w KQ - 0 1"
+	};
+
+	std::cout << "sizeof(Position) " << sizeof(Position) << " bytes, sizeof(Chess) " << sizeof(Chess) << " bytes" << std::endl;
+
+	long long times[2][2] = { { 0 } };
+	uint64_t nodes[2][2] = { { 0 } };
+	TTStats ttStats[2] = {};
+	uint64_t pawnProbes = 0;
+	uint64_t pawnHits = 0;
+	bool matching = true;
+	for (const char* fen : benchFens) {
+		Chess position;
+		position.loadFen(fen);
+
+		for (int mode = 0; mode < 2; mode++) {
+			auto t1 = std::chrono::high_resolution_clock::now();
+			uint64_t perftNodes = mode == 0 ? perftBulk(position, depth) : perftCopyMake(position, depth);
+			auto t2 = std::chrono::high_resolution_clock::now();
+			times[0][mode] += std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
+			nodes[0][mode] += perftNodes;
+
+			Minimax searcher;
+			searcher.copyMake = mode == 1;
+			t1 = std::chrono::high_resolution_clock::now();
+			FinalEvaluation result = searcher.searchABPruning(position, depth);
+			t2 = std::chrono::high_resolution_clock::now();
+			times[1][mode] += std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
+			nodes[1][mode] += result.steps;
+
+			TTStats stats = searcher.getTTStats();
+			ttStats[mode].probes += stats.probes;
+			ttStats[mode].hits += stats.hits;
+			ttStats[mode].collisions += stats.collisions;
+			pawnProbes += searcher.pawnTable.probes;
+			pawnHits += searcher.pawnTable.hits;
+		}
+	}
+
+	const char* names[] = { "perft ", "search" };
+	for (int i = 0; i < 2; i++) {
+		matching = matching && nodes[i][0] == nodes[i][1];
+		std::cout << names[i] << " make/undo " << nodes[i][0] << " nodes " << times[i][0] << "ms "
+			<< nodes[i][0] / (times[i][0] + 1) << " knps, copy-make " << nodes[i][1] << " nodes " << times[i][1] << "ms "
+			<< nodes[i][1] / (times[i][1] + 1) << " knps" << std::endl;
+	}
+	std::cout << "tt probes " << ttStats[0].probes << " hits " << ttStats[0].hits << " collisions " << ttStats[0].collisions << std::endl;
+	std::cout << "pawn table probes " << pawnProbes << " hit rate " << (double)pawnHits * 100 / (pawnProbes + 1) << "%" << std::endl;
+
+	if (!matching) {
+		std::cout << "Node counts differ between the modes" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+// Time to reach a fixed depth with 1 to 16 threads. Every run starts with an empty table. With numa the helper
+// threads are pinned to the nodes, and the speed of each node is printed.
+int runSmpBench(int depth, bool numa) {
+	const char* benchFens[] = {
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"r1bq1rk1/pp2bppp/2n2n2/3p4/3P4/2NBPN2/PP3PPP/R2QK2R w KQ - 0 1",
+		"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"
+	};
+
+	long long baseTime = 0;
+	for (int threads : { 1, 2, 4, 8, 16 }) {
+		long long totalTime = 0;
+		uint64_t totalNodes = 0;
+		std::vector<uint64_t> nodeSteps(Numa::getNodeCount(), 0);
+		for (const char* fen : benchFens) {
+			Chess position;
+			position.loadFen(fen);
+
+			Minimax searcher;
+			searcher.numaPinning = numa;
+			searcher.setThreads(threads);
+			SearchLimits limits;
+			limits.depth = depth;
+
+			auto t1 = std::chrono::high_resolution_clock::now();
+			FinalEvaluation result = searcher.search(position, limits);
+			auto t2 = std::chrono::high_resolution_clock::now();
+			totalTime += std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
+			totalNodes += result.steps;
+			for (size_t node = 0; node < searcher.nodeSteps.size(); node++) {
+				nodeSteps[node] += searcher.nodeSteps[node];
+			}
+		}
+
+		if (threads == 1) baseTime = totalTime;
+		std::cout << threads << " threads: " << totalTime << "ms, " << totalNodes << " nodes, "
+			<< totalNodes / (totalTime + 1) << " knps, speedup " << (double)baseTime / (totalTime + 1) << std::endl;
+		for (size_t node = 0; node < nodeSteps.size(); node++) {
+			std::cout << "    node " << node << ": " << nodeSteps[node] / (totalTime + 1) << " knps" << std::endl;
+		}
+	}
+
+	return 0;
+}
+
+// Nodes and time to reach a fixed depth with every pruning and extension on, with each one turned off in turn, and
+// with all off
+int runPruneBench(int depth) {
+	const char* benchFens[] = {
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"r1bq1rk1/pp2bppp/2n2n2/3p4/3P4/2NBPN2/PP3PPP/R2QK2R w KQ - 0 1",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"
+	};
+	const char* names[] = { "all on", "no null move", "no lmr", "no reverse futility", "no futility",
+		"no see pruning", "no check extension", "no singular extension", "all off" };
+
+	for (int config = 0; config < 9; config++) {
+		long long totalTime = 0;
+		uint64_t totalNodes = 0;
+		for (const char* fen : benchFens) {
+			Chess position;
+			position.loadFen(fen);
+
+			Minimax searcher;
+			searcher.nullMovePruning = config != 1 && config != 8;
+			searcher.lateMoveReductions = config != 2 && config != 8;
+			searcher.reverseFutilityPruning = config != 3 && config != 8;
+			searcher.futilityPruning = config != 4 && config != 8;
+			searcher.seePruning = config != 5 && config != 8;
+			searcher.checkExtensions = config != 6 && config != 8;
+			searcher.singularExtensions = config != 7 && config != 8;
+
+			auto t1 = std::chrono::high_resolution_clock::now();
+			FinalEvaluation result = searcher.searchABPruning(position, depth);
+			auto t2 = std::chrono::high_resolution_clock::now();
+			totalTime += std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
+			totalNodes += result.steps;
+		}
+
+		std::cout << names[config] << ": " << totalNodes << " nodes " << totalTime << "ms" << std::endl;
+	}
+
+	return 0;
+}
+
+// Fills the game history with knight moves and checks the move after the last one is refused, perft and the search
+// still work on the full history and every move can be undone back to the start position
+int runHistoryTest(void) {
+	const Square shuffle[4][2] = { { G1, F3 }, { G8, F6 }, { F3, G1 }, { F6, G8 } };
+
+	Chess position;
+	std::string startFen = position.getFen();
+
+	auto findMove = [&position](Square from, Square to) {
+		for (Move m : position.getLegalMoves()) {
+			if (m.getFrom() == from && m.getTo() == to) return m;
+		}
+		return Move();
+	};
+
+	for (int i = 0; i < MAX_HISTORY; i++) {
+		if (!position.makeMove(findMove(shuffle[i % 4][0], shuffle[i % 4][1]))) {
+			std::cout << "History test failed: move " << i << " was refused" << std::endl;
+			return 1;
+		}
+	}
+
+	std::string fullFen = position.getFen();
+	if (position.makeMove(findMove(shuffle[MAX_HISTORY % 4][0], shuffle[MAX_HISTORY % 4][1]))
+		|| position.totalMoves != MAX_HISTORY || position.getFen() != fullFen) {
+		std::cout << "History test failed: a move was made with the history full" << std::endl;
+		return 1;
+	}
+
+	// Perft copy-makes or restarts the history when it has no room, the counts must match a position without history
+	Chess fresh;
+	fresh.loadFen(fullFen);
+	PerftResults perftFull = position.perft(3);
+	PerftResults perftFresh = fresh.perft(3);
+	if (perftFull.totalCount != perftFresh.totalCount || perftFull.captures != perftFresh.captures
+		|| perftBulk(position, 4) != perftBulk(fresh, 4) || perftBulkParallel(position, 4) != perftBulk(fresh, 4)
+		|| position.totalMoves != MAX_HISTORY || position.getFen() != fullFen) {
+		std::cout << "History test failed: perft on the full history" << std::endl;
+		return 1;
+	}
+
+	Minimax searcher;
+	FinalEvaluation result = searcher.searchABPruning(position, 4);
+	if (result.move.move == 0 || position.getFen() != fullFen) {
+		std::cout << "History test failed: no search on the full history" << std::endl;
+		return 1;
+	}
+
+	for (int i = 0; i < MAX_HISTORY; i++) {
+		position.undoMove();
+	}
+	if (position.totalMoves != 0 || position.getFen() != startFen) {
+		std::cout << "History test failed: undoing the moves did not give back the start position" << std::endl;
+		return 1;
+	}
+
+	std::cout << "History test passed" << std::endl;
+	return 0;
+}
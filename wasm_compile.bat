@@ -1 +1 @@
-emcc src/chess/move_structs.cpp src/chess/generator.cpp src/chess/chess.cpp src/engine/minimax.cpp src/bindings.cpp -o webui/public/balarama.js -s MODULARIZE=1 -s EXPORT_ES6=1 -s ENVIRONMENT=web -lembind -O3 -s ASSERTIONS=1 -s TOTAL_MEMORY=536870912
\ No newline at end of file
+emcc src/chess/move_structs.cpp src/chess/generator.cpp src/chess/position.cpp src/chess/chess.cpp src/chess/zobrist.cpp src/chess/piecesquare.cpp src/chess/perft.cpp src/engine/transposition.cpp src/engine/movepicker.cpp src/engine/pawntable.cpp src/engine/numa.cpp src/engine/minimax.cpp src/bindings.cpp -o webui/public/balarama.js -s MODULARIZE=1 -s EXPORT_ES6=1 -s ENVIRONMENT=web -lembind -fconstexpr-steps=1000000000 -O3 -s ASSERTIONS=1 -s TOTAL_MEMORY=536870912
\ No newline at end of file
@@ -4,10 +4,19 @@ let Module = null
 let Chess = null
 let Engine = null
 let legalMoves = null
-const depth = 4
+// Every field is needed by the bindings, zero means no limit
+const searchLimits = {
+    depth: 64,
+    moveTime: 1000,
+    timeLeft: 0,
+    increment: 0,
+    movesToGo: 0,
+    nodes: 0,
+    infinite: false
+}
 
 const getEvaluation = () => {
-    const evaluation = Engine.searchABPruning(Chess, depth)
+    const evaluation = Engine.search(Chess, searchLimits)
     const move = Module.getJSMove(evaluation.move)
     const pieceType = Chess.getPieceAt(move.from)
     let pieceChar = String.fromCharCode(Module.pieceToString(pieceType))
@@ -35,7 +44,6 @@ self.onmessage = async function (e) {
 
     if (!Chess) {
         Chess = new Module.Chess()
-        // chess.load_fen(fen)
     }
 
     if (!Engine) {
@@ -44,6 +52,9 @@ self.onmessage = async function (e) {
 
     if (fen) {
         Chess = new Module.Chess()
+        if (!Chess.loadFen(fen)) {
+            console.log('invalid fen: ', fen)
+        }
     }
 
     if (newMove && legalMoves) {